@@ -0,0 +1,56 @@
+#include "allocCounter.h"
+//--
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Kept in its own translation unit so the replaced operators are not
+// inlined next to the standard ones
+//-------------------------------------
+static std::atomic<uint64_t> gAllocations {};
+
+//-------------------------------------
+uint64_t
+Bench::allocations() {
+    return gAllocations.load(std::memory_order_relaxed);
+}
+
+//-------------------------------------
+void *
+operator new(std::size_t size) {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+//-------------------------------------
+void *
+operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+//-------------------------------------
+void
+operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+//-------------------------------------
+void
+operator delete[](void *ptr) noexcept {
+    std::free(ptr);
+}
+
+//-------------------------------------
+void
+operator delete(void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+//-------------------------------------
+void
+operator delete[](void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
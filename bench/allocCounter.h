@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+//-------------------------------------
+namespace Bench {
+
+    // Heap allocations done by the process so far (global operator new)
+    uint64_t allocations();
+
+} // end of namespace
@@ -0,0 +1,571 @@
+//------------------------------------------------------------------------------
+// Feed decoding benchmark
+//
+//   feedBench [frames.txt] [repeat]
+//
+// frames.txt holds one stream frame per line (MollyBet --capture).
+// Without it a synthetic burst shaped like the pre-sync snapshot is used.
+//------------------------------------------------------------------------------
+
+#include "allocCounter.h"
+#include "feed/arenaJson.h"
+#include "feed/feedDecoder.h"
+#include "feed/incrementalScanner.h"
+#include "feed/syncDetector.h"
+#include "feed/timestamp.h"
+#include "feed/utf8Validator.h"
+#include "molly/codes.h"
+#include "molly/marketKey.h"
+#include "molly/messageDecoder.h"
+#include "molly/messageStore.h"
+#include "molly/parallelDecoder.h"
+#include "utils/decimal.h"
+#include "utils/stringInterner.h"
+//--
+#include <boost/beast/websocket/detail/utf8_checker.hpp>
+#include <nlohmann/json.hpp>
+//--
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using json = nlohmann::json;
+
+//-------------------------------------
+struct Input {
+    std::vector<std::string>    frames;
+    std::size_t                 bytes {};
+    std::size_t                 messages {};
+};
+
+//-------------------------------------
+static std::vector<std::string>
+syntheticFrames() {
+    static const char *kCompetitions[] = { "Premier League", "La Liga", "Serie A", "Bundesliga", "Ligue 1", "Eredivisie", "MLS", "J1 League" };
+    static const char *kBookies[]      = { "pin", "sbo", "ibc", "bf", "bdaq" };
+    static const char *kBetTypes[]     = { "for,ah,h,-2", "for,ah,a,2", "for,tu,5", "for,to,5", "for,ml,h", "for,ml,a", "for,dc,h,d" };
+
+    std::vector<std::string> frames;
+    char buffer[512];
+    for (int k = 0; k < 500; ++k) {
+        std::string frame = "{\"ts\": " + std::to_string(1714566600 + k) + ".5, \"data\": [";
+        for (int j = 0; j < 40; ++j) {
+            const int i = k * 40 + j;
+            if (j % 5 == 0) {
+                std::snprintf(buffer, sizeof(buffer),
+                    R"(["event", {"sport": "fb", "event_id": "2024-05-01,%d,%d", "competition_id": %d, "competition_name": "%s", "competition_country": "XX", "home": "Team %d", "away": "Team é %d", "start_time": "2024-05-01T12:30:00Z", "ir_status": "pre_match", "event_type": "normal"}])",
+                    i, i + 1, i % 8, kCompetitions[i % 8], i, i + 1);
+            }
+            else {
+                std::snprintf(buffer, sizeof(buffer),
+                    R"(["offer", {"sport": "fb", "event_id": "2024-05-01,%d,%d", "bet_type": "%s", "bookie": "%s", "price": %.3f, "min": ["EUR", 5.0], "max": ["EUR", %.2f], "ts": 1714566600.123}])",
+                    i, i + 1, kBetTypes[i % 7], kBookies[(i / 5) % 5], 1.01 + (i % 400) / 100.0, 10.0 + (i % 990));
+            }
+            frame += j ? ", " : "";
+            frame += buffer;
+        }
+        if (k == 499) {
+            frame += R"(, ["sync", {"token": "resume-token-42"}])";
+        }
+        frame += "]}";
+        frames.emplace_back(std::move(frame));
+    }
+    return frames;
+}
+
+//-------------------------------------
+static bool
+loadInput(const char *path, Input &input) {
+    if (path != nullptr) {
+        std::ifstream file(path, std::ios::binary);
+        if (file.is_open() == false) {
+            std::fprintf(stderr, "Cannot open '%s'\n", path);
+            return false;
+        }
+        for (std::string line; std::getline(file, line); ) {
+            if (line.empty() == false) {
+                input.frames.emplace_back(std::move(line));
+            }
+        }
+    }
+    else {
+        input.frames = syntheticFrames();
+    }
+
+    Molly::FeedDecoder decoder({});
+    const Molly::FeedDecoder::MessageHandler count = [&](const Molly::FeedMessage &) { ++input.messages; };
+    for (const auto &frame : input.frames) {
+        input.bytes += frame.size();
+        decoder.decode(frame, count);
+    }
+    return input.frames.empty() == false;
+}
+
+// Runs body over every frame, repeat times, and prints throughput
+//-------------------------------------
+template <typename Body>
+static void
+measure(const char *name, const Input &input, int repeat, Body &&body) {
+    // Warm up: first use buffers are not steady state
+    for (const auto &frame : input.frames) {
+        body(frame);
+    }
+
+    const auto allocations = Bench::allocations();
+    const auto start       = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; ++r) {
+        for (const auto &frame : input.frames) {
+            body(frame);
+        }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const double seconds  = elapsed.count();
+    const double bytes    = double(input.bytes) * repeat;
+    const double messages = double(input.messages) * repeat;
+    std::printf("%-28s %9.1f MB/s %9.2f M msg/s %8.1f ns/msg %8.2f allocs/msg\n",
+                name, bytes / (1024.0 * 1024.0) / seconds, messages / 1e6 / seconds,
+                seconds * 1e9 / messages, double(Bench::allocations() - allocations) / messages);
+}
+
+// Text of the number or string values of key in the frames, unquoted
+//-------------------------------------
+static std::vector<std::string_view>
+collectValues(const Input &input, std::string_view key) {
+    const std::string pattern = "\"" + std::string(key) + "\":";
+
+    std::vector<std::string_view> values;
+    for (std::string_view frame : input.frames) {
+        for (auto pos = frame.find(pattern); pos != std::string_view::npos; pos = frame.find(pattern, pos + 1)) {
+            auto begin = frame.find_first_not_of(' ', pos + pattern.size());
+            auto end   = std::string_view::npos;
+            if (begin != std::string_view::npos && frame[begin] == '"') {
+                end = frame.find('"', ++begin);
+            }
+            else {
+                end = frame.find_first_not_of("+-.0123456789eE", begin);
+            }
+            if (begin != std::string_view::npos && end != std::string_view::npos && end > begin) {
+                values.push_back(frame.substr(begin, end - begin));
+            }
+        }
+    }
+    return values;
+}
+
+// Text of the "price" numbers and ["EUR", 5.0] amounts in the frames
+//-------------------------------------
+static std::vector<std::string_view>
+collectNumbers(const Input &input) {
+    std::vector<std::string_view> numbers = collectValues(input, "price");
+    for (std::string_view frame : input.frames) {
+        for (auto pos = frame.find("[\""); pos != std::string_view::npos; pos = frame.find("[\"", pos + 1)) {
+            if (frame.compare(pos + 5, 3, "\", ") == 0) {
+                const auto end = frame.find_first_not_of(".0123456789", pos + 8);
+                if (end != std::string_view::npos && end > pos + 8) {
+                    numbers.push_back(frame.substr(pos + 8, end - pos - 8));
+                }
+            }
+        }
+    }
+    return numbers;
+}
+
+// Runs parse over every field, and prints its cost per field
+//-------------------------------------
+template <typename Parse>
+static void
+measureFields(const char *name, const std::vector<std::string_view> &fields, int repeat, Parse &&parse) {
+    const int rounds = repeat * 200;
+
+    double      sum {};
+    const auto  start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (const auto &text : fields) {
+            sum += parse(text);
+        }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const double count = double(fields.size()) * rounds;
+    std::printf("%-28s %9.2f M fields/s %8.1f ns/field   (sum %.2f)\n",
+                name, count / 1e6 / elapsed.count(), elapsed.count() * 1e9 / count, sum / rounds);
+}
+
+// What main.cpp used to do with every frame
+//-------------------------------------
+template <typename Json>
+static void
+walkDOM(const Json &j, bool &syncFound, std::string &token, std::unordered_set<std::string> &competitions) {
+    auto text = [](const Json &value) {
+        const auto &string = value.template get_ref<const typename Json::string_t &>();
+        return std::string(string.data(), string.size());
+    };
+
+    if (j.is_object()) {
+        for (auto it = j.begin(); it != j.end(); ++it) {
+            if (it.value().is_object() || it.value().is_array()) {
+                walkDOM(it.value(), syncFound, token, competitions);
+            }
+            else if (it.key() == "competition_name" && it.value().is_string()) {
+                competitions.emplace(text(it.value()));
+            }
+            else if (syncFound && it.key() == "token" && it.value().is_string()) {
+                token = text(it.value());
+            }
+        }
+    }
+    else if (j.is_array()) {
+        for (const auto &item : j) {
+            walkDOM(item, syncFound, token, competitions);
+        }
+    }
+    else if (j.is_string() && j.template get_ref<const typename Json::string_t &>() == "sync") {
+        syncFound = true;
+    }
+}
+
+//-------------------------------------
+int
+main(int argc, char **argv) {
+    Input input;
+    if (loadInput(argc > 1 ? argv[1] : nullptr, input) == false) {
+        return EXIT_FAILURE;
+    }
+    const int repeat = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+
+    std::printf("%zu frames, %.2f MB, %zu messages, x%d\n\n",
+                input.frames.size(), double(input.bytes) / (1024.0 * 1024.0), input.messages, repeat);
+
+    bool syncFound {};
+    std::string token;
+    std::unordered_set<std::string> competitions;
+
+    measure("json::parse + walk", input, repeat, [&](const std::string &frame) {
+        walkDOM(json::parse(frame), syncFound, token, competitions);
+    });
+
+    // Same DOM from a per-frame arena, reset after each frame
+    MindShake::MonotonicArena arena;
+    measure("json::parse (arena) + walk", input, repeat, [&](const std::string &frame) {
+        {
+            MindShake::ArenaScope scope(arena);
+            walkDOM(Molly::ArenaJson::parse(frame), syncFound, token, competitions);
+        }
+        arena.reset();
+    });
+    std::printf("%-28s %llu chunks (%llu KB) for %llu allocations over %llu frames\n",
+                "  arena", (unsigned long long) arena.getStats().chunks, (unsigned long long) arena.getStats().chunkBytes / 1024,
+                (unsigned long long) arena.getStats().allocations, (unsigned long long) arena.getStats().resets);
+
+    Molly::FeedDecoder decoder({ "competition_name", "token" });
+    const Molly::FeedDecoder::MessageHandler collect = [&](const Molly::FeedMessage &message) {
+        if (message[0].kind == Molly::FieldValue::Kind::String && competitions.count(message[0].text) == 0) {
+            competitions.emplace(message[0].text);
+        }
+        if (message.type == "sync") {
+            syncFound = true;
+            token     = message[1].text;
+        }
+    };
+    measure("FeedDecoder (SAX)", input, repeat, [&](const std::string &frame) {
+        decoder.decode(frame, collect);
+    });
+
+    Molly::FeedDecoder gated({ "competition_name", "token" });
+    gated.subscribe({ "event", "sync" });
+    measure("FeedDecoder (type-gated)", input, repeat, [&](const std::string &frame) {
+        gated.decode(frame, collect);
+    });
+
+    // Tape backend with every kernel this CPU can run
+    const auto best = Molly::StructuralIndex::detect();
+    for (int isa = int(best); isa >= 0; --isa) {
+        Molly::FeedDecoder tape({ "competition_name", "token" });
+        tape.setBackend(Molly::FeedDecoder::Backend::Tape);
+        tape.getTape().getIndex().setIsa(Molly::StructuralIndex::Isa(isa));
+
+        std::string name = std::string("tape, ") + Molly::StructuralIndex::getName(Molly::StructuralIndex::Isa(isa));
+        measure(name.c_str(), input, repeat, [&](const std::string &frame) {
+            tape.decode(frame, collect);
+        });
+
+        tape.subscribe({ "event", "sync" });
+        name += ", gated";
+        measure(name.c_str(), input, repeat, [&](const std::string &frame) {
+            tape.decode(frame, collect);
+        });
+    }
+
+    Molly::MessageDecoder typed;
+    typed.subscribe({ Molly::MessageType::Event, Molly::MessageType::Sync });
+    const auto visitor = Molly::Overloaded {
+        [&](const Molly::Event &event) {
+            std::string name(event.competitionName);
+            if (competitions.count(name) == 0) {
+                competitions.emplace(std::move(name));
+            }
+        },
+        [&](const Molly::Sync &sync) {
+            syncFound = true;
+            token     = sync.token;
+        },
+        [](const auto &) {
+        },
+    };
+    const Molly::MessageDecoder::Handler onMessage = [&](const Molly::Message &message, Molly::FieldMask) {
+        std::visit(visitor, message);
+    };
+    measure("MessageDecoder (typed)", input, repeat, [&](const std::string &frame) {
+        typed.decode(frame, onMessage);
+    });
+
+    Molly::MessageDecoder typedAll;
+    measure("MessageDecoder (all types)", input, repeat, [&](const std::string &frame) {
+        typedAll.decode(frame, onMessage);
+    });
+
+    // Key lookups for every field, against keys checked in the learned order
+    Molly::MessageDecoder generic;
+    generic.setSpeculative(false);
+    measure("MessageDecoder (lookups)", input, repeat, [&](const std::string &frame) {
+        generic.decode(frame, onMessage);
+    });
+    const auto &shapes = typedAll.getStats();
+    std::printf("%-28s %.1f%% of records in a learned key order\n", "speculative key order",
+                100.0 * shapes.shapeHits / std::max<uint64_t>(1, shapes.shapeHits + shapes.shapeMisses));
+
+    // The same consumer wanting one bookie and sport: checked in its handler
+    // after a full decode, or pushed down so the rest is never decoded
+    const Molly::MessageDecoder::Handler onPicked = [&](const Molly::Message &message, Molly::FieldMask) {
+        const auto *offer = std::get_if<Molly::Offer>(&message);
+        if (offer == nullptr || (offer->bookie.value == Molly::Bookie::Pinnacle && offer->sport.value == Molly::Sport::Football)) {
+            std::visit(visitor, message);
+        }
+    };
+    measure("Decoder, filter in handler", input, repeat, [&](const std::string &frame) {
+        typedAll.decode(frame, onPicked);
+    });
+    Molly::MessageDecoder filtered;
+    filtered.setFilter(Molly::MessageFilter().addBookie(Molly::Bookie::Pinnacle).addSport(Molly::Sport::Football));
+    measure("Decoder, filter pushed down", input, repeat, [&](const std::string &frame) {
+        filtered.decode(frame, onMessage);
+    });
+    const auto &bookieFilter = filtered.getFilterStats().bookies;
+    std::printf("%-28s %llu offers passed, %llu skipped undecoded\n", "pushed-down bookie filter", (unsigned long long) bookieFilter.hits, (unsigned long long) bookieFilter.skips);
+
+    // Offers kept up to date: each one copied whole into owned strings, as
+    // a DOM per message would, or merged in place field by field
+    struct OwnedOffer {
+        std::string         eventId, betType, bookie, minCurrency, maxCurrency;
+        Molly::Decimal      price, min, max;
+        Molly::Timestamp    ts;
+    };
+    std::unordered_map<std::string, OwnedOffer> replaced;
+    std::string offerKey;
+    const Molly::MessageDecoder::Handler onReplaced = [&](const Molly::Message &message, Molly::FieldMask) {
+        if (const auto *offer = std::get_if<Molly::Offer>(&message)) {
+            offerKey.assign(offer->eventId).append(offer->betType.text).append(offer->bookie.text);
+            replaced[offerKey] = { std::string(offer->eventId), std::string(offer->betType.text), std::string(offer->bookie.text),
+                                   std::string(offer->min.currency), std::string(offer->max.currency),
+                                   offer->price, offer->min.value, offer->max.value, offer->ts };
+        }
+    };
+    Molly::MessageDecoder offers;
+    offers.setFilter(Molly::MessageFilter().addType(Molly::MessageType::Offer));
+    measure("offers, replaced whole", input, repeat, [&](const std::string &frame) {
+        offers.decode(frame, onReplaced);
+    });
+    Molly::MessageStore store;
+    const Molly::MessageDecoder::Handler onMerged = [&](const Molly::Message &message, Molly::FieldMask fields) {
+        store.apply(message, fields);
+    };
+    measure("offers, MessageStore merge", input, repeat, [&](const std::string &frame) {
+        offers.decode(frame, onMerged);
+    });
+    const auto &stored = store.getStats();
+    std::printf("%-28s %zu offers, %llu updates, %llu fields changed\n", "store",
+                store.getOffers(), (unsigned long long) stored.updates, (unsigned long long) stored.changed);
+
+    // What main.cpp does: names become interned ids
+    MindShake::StringInterner names;
+    const Molly::MessageDecoder::Handler onInterned = [&](const Molly::Message &message, Molly::FieldMask) {
+        if (const auto *event = std::get_if<Molly::Event>(&message)) {
+            names.intern(event->competitionName);
+        }
+    };
+    measure("MessageDecoder (interned)", input, repeat, [&](const std::string &frame) {
+        typed.decode(frame, onInterned);
+    });
+
+    // Frames cut as async_read_some would hand them over
+    Molly::IncrementalScanner scanner;
+    const auto onElement = [&](std::string_view element) {
+        typed.decodeMessage(element, onMessage);
+    };
+    measure("MessageDecoder (16 KB pieces)", input, repeat, [&](const std::string &frame) {
+        constexpr std::size_t kPiece = 16 * 1024;
+        for (std::size_t offset = 0; offset < frame.size(); offset += kPiece) {
+            scanner.feed(std::string_view(frame).substr(offset, kPiece), onElement);
+        }
+        scanner.finish();
+    });
+
+    // The same burst spread over the cores, merged back in order at its end
+    MindShake::WorkerPool workers;
+    Molly::ParallelDecoder parallel(workers);
+    parallel.subscribe({ Molly::MessageType::Event, Molly::MessageType::Sync });
+    const std::string name = "MessageDecoder (" + std::to_string(workers.size()) + " workers)";
+    measure(name.c_str(), input, repeat, [&](const std::string &frame) {
+        parallel.decode(frame, onMessage);
+        if (&frame == &input.frames.back()) {
+            parallel.flush(onMessage);
+        }
+    });
+
+    // UTF-8: what Beast runs on every text frame, against the decoder's
+    // own check, and the typed decoder with it skipped
+    measure("UTF-8, Beast utf8_checker", input, repeat, [&](const std::string &frame) {
+        syncFound |= boost::beast::websocket::detail::check_utf8(frame.data(), frame.size()) == false;
+    });
+    for (int isa = int(best); isa >= 0; --isa) {
+        const auto which = Molly::StructuralIndex::Isa(isa);
+        const std::string name = std::string("UTF-8, ") + Molly::StructuralIndex::getName(which);
+        measure(name.c_str(), input, repeat, [&](const std::string &frame) {
+            syncFound |= Molly::Utf8Validator::validate(frame, which) == false;
+        });
+    }
+    Molly::MessageDecoder trusted;
+    trusted.subscribe({ Molly::MessageType::Event, Molly::MessageType::Sync });
+    trusted.setTrusted(true);
+    measure("MessageDecoder (trusted)", input, repeat, [&](const std::string &frame) {
+        trusted.decode(frame, onMessage);
+    });
+
+    Molly::StructuralIndex index;
+    measure("structural index only", input, repeat, [&](const std::string &frame) {
+        index.build(frame);
+    });
+
+    // What the session does with every frame before decoding it
+    for (int isa = int(best); isa >= 0; --isa) {
+        Molly::SyncDetector detector;
+        detector.setIsa(Molly::StructuralIndex::Isa(isa));
+
+        const std::string name = std::string("sync detector, ") + Molly::StructuralIndex::getName(Molly::StructuralIndex::Isa(isa));
+        measure(name.c_str(), input, repeat, [&](const std::string &frame) {
+            syncFound |= detector.find(frame) != Molly::SyncDetector::kNotFound;
+        });
+    }
+
+    // Price and stake fields on their own: double conversions against
+    // the fixed-point parse the typed decoder uses
+    const auto numbers = collectNumbers(input);
+    std::printf("\n%zu price and amount fields\n", numbers.size());
+
+    measureFields("strtod", numbers, repeat, [](std::string_view text) {
+        char number[64];
+        std::memcpy(number, text.data(), text.size());
+        number[text.size()] = 0;
+        return std::strtod(number, nullptr);
+    });
+    measureFields("std::from_chars (double)", numbers, repeat, [](std::string_view text) {
+        double value {};
+        std::from_chars(text.data(), text.data() + text.size(), value);
+        return value;
+    });
+    measureFields("Decimal::parse", numbers, repeat, [](std::string_view text) {
+        MindShake::Decimal value;
+        MindShake::Decimal::parse(text, value);
+        return value.toDouble();
+    });
+
+    // Timestamps: generic text handling against what the typed decoder uses
+    const auto startTimes = collectValues(input, "start_time");
+    std::printf("\n%zu start_time fields\n", startTimes.size());
+
+    measureFields("sscanf + days", startTimes, repeat, [](std::string_view text) {
+        char copy[64];
+        std::memcpy(copy, text.data(), std::min(text.size(), sizeof(copy) - 1));
+        copy[std::min(text.size(), sizeof(copy) - 1)] = 0;
+        unsigned year, month, day, hour, minute, second;
+        if (std::sscanf(copy, "%4u-%2u-%2uT%2u:%2u:%2u", &year, &month, &day, &hour, &minute, &second) != 6) {
+            return 0.0;
+        }
+        // days_from_civil
+        const int      y   = int(year) - (month <= 2);
+        const unsigned yoe = unsigned(y % 400);
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+        const int64_t  days = int64_t(y / 400) * 146097 + doe - 719468;
+        return double(days * 86400 + hour * 3600 + minute * 60 + second);
+    });
+    // AVX2 would not help with 19 bytes: SSE4.2 is the widest kernel
+    for (int isa = std::min(int(best), int(Molly::StructuralIndex::Isa::SSE42)); isa >= 0; --isa) {
+        const auto which = Molly::StructuralIndex::Isa(isa);
+        const std::string name = std::string("parseIso8601, ") + Molly::StructuralIndex::getName(which);
+        measureFields(name.c_str(), startTimes, repeat, [which](std::string_view text) {
+            Molly::Timestamp value;
+            Molly::Timestamp::parseIso8601(text, value, which);
+            return double(value.ns / Molly::Timestamp::kNanosPerSecond);
+        });
+    }
+
+    const auto stamps = collectValues(input, "ts");
+    std::printf("\n%zu ts fields\n", stamps.size());
+
+    measureFields("strtod", stamps, repeat, [](std::string_view text) {
+        char number[64];
+        std::memcpy(number, text.data(), text.size());
+        number[text.size()] = 0;
+        return std::strtod(number, nullptr);
+    });
+    measureFields("parseEpoch", stamps, repeat, [](std::string_view text) {
+        Molly::Timestamp value;
+        Molly::Timestamp::parseEpoch(text, value);
+        return value.toSeconds();
+    });
+
+    // bet_types: tokenized every time against a packed key from the cache
+    const auto betTypes = collectValues(input, "bet_type");
+    std::printf("\n%zu bet_type fields\n", betTypes.size());
+
+    measureFields("split into strings", betTypes, repeat, [](std::string_view text) {
+        std::vector<std::string> tokens;
+        for (std::size_t begin = 0, comma = 0; comma != std::string_view::npos; begin = comma + 1) {
+            comma = text.find(',', begin);
+            tokens.emplace_back(text.substr(begin, comma == std::string_view::npos ? comma : comma - begin));
+        }
+        return double(tokens.size());
+    });
+    measureFields("MarketKey::parse", betTypes, repeat, [](std::string_view text) {
+        return double(Molly::MarketKey::parse(text).value & 0xFF);
+    });
+    Molly::MarketKeyCache markets;
+    measureFields("MarketKeyCache::get", betTypes, repeat, [&markets](std::string_view text) {
+        return double(markets.get(text).value & 0xFF);
+    });
+
+    // Per-bookie counters: a map keyed by name against an array by enum
+    const auto bookies = collectValues(input, "bookie");
+    std::printf("\n%zu bookie fields\n", bookies.size());
+
+    std::unordered_map<std::string, uint64_t> perBookieMap;
+    measureFields("unordered_map<string>", bookies, repeat, [&perBookieMap](std::string_view text) {
+        return double(++perBookieMap[std::string(text)]);
+    });
+    std::array<uint64_t, std::size_t(Molly::Bookie::Count) + 1> perBookie {};
+    measureFields("findCode + array", bookies, repeat, [&perBookie](std::string_view text) {
+        return double(++perBookie[std::size_t(Molly::findCode<Molly::Bookie>(text))]);
+    });
+
+    return competitions.empty() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
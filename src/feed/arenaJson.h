@@ -0,0 +1,27 @@
+#pragma once
+
+#include "utils/monotonicArena.h"
+//--
+#include <nlohmann/json.hpp>
+//--
+#include <map>
+#include <string>
+#include <vector>
+
+//-------------------------------------
+namespace Molly {
+
+    using ArenaString = std::basic_string<char, std::char_traits<char>, MindShake::ArenaAllocator<char>>;
+
+    // nlohmann DOM whose strings, objects and arrays come from the
+    // MonotonicArena of the enclosing ArenaScope. Build it, use it and
+    // destroy it inside one scope, then reset the arena:
+    //
+    //     MindShake::ArenaScope scope(arena);
+    //     auto doc = ArenaJson::parse(text);
+    //     ...
+    //
+    // String values are ArenaString: read them with get_ref, not get<std::string>.
+    using ArenaJson = nlohmann::basic_json<std::map, std::vector, ArenaString, bool, std::int64_t, std::uint64_t, double, MindShake::ArenaAllocator>;
+
+} // end of namespace
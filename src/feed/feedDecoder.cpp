@@ -0,0 +1,337 @@
+#include "feedDecoder.h"
+#include "feedScanner.h"
+
+//-------------------------------------
+namespace Molly {
+
+    // Container depth of each part of a frame
+    //---------------------------------
+    constexpr std::size_t kFrameDepth   = 1;
+    constexpr std::size_t kDataDepth    = 2;
+    constexpr std::size_t kMessageDepth = 3;
+    constexpr std::size_t kPayloadDepth = 4;
+
+    // nlohmann SAX interface, forwarding to the decoder state
+    //---------------------------------
+    class FeedDecoder::Sax {
+        public:
+            using Json = FeedDecoder::Json;
+
+        public:
+            explicit Sax(FeedDecoder &decoder) : d(decoder) { }
+
+            bool null() {
+                if (isField()) {
+                    d.setField(FieldValue::Kind::Null);
+                }
+                return true;
+            }
+
+            bool boolean(bool value) {
+                if (isField()) {
+                    d.mMessage.fields[d.mField].boolean = value;
+                    d.setField(FieldValue::Kind::Bool);
+                }
+                return true;
+            }
+
+            bool number_integer(Json::number_integer_t value) {
+                return integer(value);
+            }
+
+            bool number_unsigned(Json::number_unsigned_t value) {
+                return integer(int64_t(value));
+            }
+
+            bool number_float(Json::number_float_t value, const Json::string_t &) {
+                if (d.mDepth == kFrameDepth && d.mTopKey == TopKey::Ts) {
+                    d.mMessage.frameTs = value;
+                }
+                else if (isField()) {
+                    d.mMessage.fields[d.mField].number = value;
+                    d.setField(FieldValue::Kind::Number);
+                }
+                return true;
+            }
+
+            bool string(Json::string_t &value) {
+                if (d.mDepth == kMessageDepth && d.mInMessage && d.mHasType == false) {
+                    d.mMessage.type.assign(value);
+                    d.mHasType = true;
+                }
+                else if (isField()) {
+                    d.mMessage.fields[d.mField].text.assign(value);
+                    d.setField(FieldValue::Kind::String);
+                }
+                return true;
+            }
+
+            bool binary(Json::binary_t &) {
+                return true;
+            }
+
+            bool start_object(std::size_t) {
+                d.mField = kNoField;
+                ++d.mDepth;
+                return true;
+            }
+
+            bool key(Json::string_t &value) {
+                if (d.mDepth == kFrameDepth) {
+                    d.mTopKey = value == "data" ? TopKey::Data : value == "ts" ? TopKey::Ts : TopKey::Other;
+                }
+                else if (d.mDepth == kPayloadDepth && d.mInMessage) {
+                    d.mField = d.fieldIndex(value);
+                }
+                return true;
+            }
+
+            bool end_object() {
+                --d.mDepth;
+                return true;
+            }
+
+            bool start_array(std::size_t) {
+                d.mField = kNoField;
+                if (d.mDepth == kFrameDepth && d.mTopKey == TopKey::Data) {
+                    d.mInData = true;
+                }
+                else if (d.mDepth == kDataDepth && d.mInData) {
+                    d.beginMessage();
+                }
+                ++d.mDepth;
+                return true;
+            }
+
+            bool end_array() {
+                --d.mDepth;
+                if (d.mDepth == kDataDepth && d.mInMessage) {
+                    d.mInMessage = false;
+                    if (d.mHasType) {
+                        ++d.mStats.decoded;
+                        (*d.mHandler)(d.mMessage);
+                    }
+                }
+                else if (d.mDepth == kFrameDepth) {
+                    d.mInData = false;
+                }
+                return true;
+            }
+
+            bool parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &e) {
+                d.mLastError = e.what();
+                return false;
+            }
+
+        protected:
+            bool isField() const {
+                return d.mField != kNoField && d.mDepth == kPayloadDepth && d.mInMessage;
+            }
+
+            bool integer(int64_t value) {
+                if (d.mDepth == kFrameDepth && d.mTopKey == TopKey::Ts) {
+                    d.mMessage.frameTs = double(value);
+                }
+                else if (isField()) {
+                    d.mMessage.fields[d.mField].integer = value;
+                    d.setField(FieldValue::Kind::Integer);
+                }
+                return true;
+            }
+
+        protected:
+            FeedDecoder &d;
+    };
+
+    //---------------------------------
+    FeedDecoder::FeedDecoder(std::vector<std::string> wantedFields)
+        : mWantedFields(std::move(wantedFields))
+    {
+        mMessage.fields.resize(mWantedFields.size());
+    }
+
+    // A handful of names: a linear scan beats hashing the key
+    //---------------------------------
+    std::size_t
+    FeedDecoder::fieldIndex(std::string_view name) const {
+        for (std::size_t i = 0; i < mWantedFields.size(); ++i) {
+            if (mWantedFields[i] == name) {
+                return i;
+            }
+        }
+        return kNoField;
+    }
+
+    //---------------------------------
+    bool
+    FeedDecoder::isSubscribed(std::string_view type) const {
+        for (const auto &subscribed : mSubscribed) {
+            if (subscribed == type) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //---------------------------------
+    bool
+    FeedDecoder::decode(std::string_view frame, const MessageHandler &handler) {
+        mHandler   = &handler;
+        mDepth     = 0;
+        mField     = kNoField;
+        mTopKey    = TopKey::Other;
+        mInData    = false;
+        mInMessage = false;
+        mMessage.frameTs = 0;
+        mLastError.clear();
+
+        bool ok = true;
+        if (mBackend == Backend::Tape) {
+            ok = decodeTape(frame);
+        }
+        else if (mSubscribed.empty()) {
+            Sax sax(*this);
+            ok = Json::sax_parse(frame.begin(), frame.end(), &sax);
+        }
+        else {
+            const bool shaped = FeedScanner::scan(frame, mMessage.frameTs, [&](const FeedScanner::Element &element) {
+                if (isSubscribed(element.type) == false) {
+                    ++mStats.skipped;
+                }
+                else if (ok) {
+                    ok = decodeElement(element.text);
+                }
+            });
+            if (shaped == false && ok) {
+                mLastError = "malformed frame";
+                ok = false;
+            }
+        }
+
+        mHandler = nullptr;
+        return ok;
+    }
+
+    // Parsed as if it were still inside the data array
+    //---------------------------------
+    bool
+    FeedDecoder::decodeElement(std::string_view element) {
+        mDepth     = kDataDepth;
+        mField     = kNoField;
+        mInData    = true;
+        mInMessage = false;
+
+        Sax sax(*this);
+        return Json::sax_parse(element.begin(), element.end(), &sax);
+    }
+
+    // The whole frame is indexed; unsubscribed messages are skipped over
+    // on the tape and their values never looked at
+    //---------------------------------
+    bool
+    FeedDecoder::decodeTape(std::string_view frame) {
+        if (mTape.parse(frame) == false) {
+            mLastError = mTape.getError();
+            return false;
+        }
+
+        const auto &tape = mTape;
+        if (tape[0].kind != JsonTape::Kind::Object) {
+            mLastError = "frame is not an object";
+            return false;
+        }
+
+        for (auto key = JsonTape::first(0); key < tape.end(0); key = tape.next(key + 1)) {
+            const auto name  = tape.raw(key);
+            const auto value = key + 1;
+            if (name == "ts") {
+                tape.getNumber(value, mMessage.frameTs);
+            }
+            else if (name == "data" && tape[value].kind == JsonTape::Kind::Array) {
+                for (auto element = JsonTape::first(value); element < tape.end(value); element = tape.next(element)) {
+                    decodeTapeMessage(element);
+                }
+            }
+        }
+        return true;
+    }
+
+    //---------------------------------
+    void
+    FeedDecoder::decodeTapeMessage(std::size_t element) {
+        const auto &tape = mTape;
+        const auto type  = JsonTape::first(element);
+        if (tape[element].kind != JsonTape::Kind::Array || type == tape.end(element) || tape[type].kind != JsonTape::Kind::String) {
+            return;
+        }
+        if (mSubscribed.empty() == false && isSubscribed(tape.raw(type)) == false) {
+            ++mStats.skipped;
+            return;
+        }
+
+        beginMessage();
+        tape.getString(type, mMessage.type);
+
+        const auto payload = tape.next(type);
+        if (payload < tape.end(element) && tape[payload].kind == JsonTape::Kind::Object) {
+            for (auto key = JsonTape::first(payload); key < tape.end(payload); key = tape.next(key + 1)) {
+                const auto index = fieldIndex(tape.raw(key));
+                if (index == kNoField) {
+                    continue;
+                }
+
+                const auto value = key + 1;
+                auto &field = mMessage.fields[index];
+                switch (tape[value].kind) {
+                    case JsonTape::Kind::String:
+                        if (tape.getString(value, field.text)) {
+                            field.kind = FieldValue::Kind::String;
+                        }
+                        break;
+                    case JsonTape::Kind::Number:
+                        if (tape.getInteger(value, field.integer)) {
+                            field.kind = FieldValue::Kind::Integer;
+                        }
+                        else if (tape.getNumber(value, field.number)) {
+                            field.kind = FieldValue::Kind::Number;
+                        }
+                        break;
+                    case JsonTape::Kind::True:
+                    case JsonTape::Kind::False:
+                        field.boolean = tape[value].kind == JsonTape::Kind::True;
+                        field.kind    = FieldValue::Kind::Bool;
+                        break;
+                    case JsonTape::Kind::Null:
+                        field.kind = FieldValue::Kind::Null;
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+
+        mInMessage = false;
+        ++mStats.decoded;
+        (*mHandler)(mMessage);
+    }
+
+    //---------------------------------
+    void
+    FeedDecoder::beginMessage() {
+        mInMessage = true;
+        mHasType   = false;
+        mMessage.type.clear();
+        for (auto &field : mMessage.fields) {
+            field.kind = FieldValue::Kind::Missing;
+            field.text.clear();
+        }
+    }
+
+    //---------------------------------
+    void
+    FeedDecoder::setField(FieldValue::Kind kind) {
+        mMessage.fields[mField].kind = kind;
+        mField = kNoField;
+    }
+
+} // end of namespace
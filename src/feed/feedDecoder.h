@@ -0,0 +1,139 @@
+#pragma once
+
+#include "jsonTape.h"
+//--
+#include <nlohmann/json.hpp>
+//--
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//-------------------------------------
+namespace Molly {
+
+    // Scalar value of a wanted payload field
+    //---------------------------------
+    struct FieldValue {
+        enum class Kind : uint8_t {
+            Missing,
+            String,
+            Integer,
+            Number,
+            Bool,
+            Null,
+        };
+
+        Kind        kind {};
+        std::string text;       // String; keeps its capacity between messages
+        int64_t     integer {};
+        double      number {};
+        bool        boolean {};
+
+        bool        isMissing() const   { return kind == Kind::Missing; }
+        double      asNumber() const    { return kind == Kind::Integer ? double(integer) : number; }
+    };
+
+    // One ["type", {payload}] entry of a stream frame. Only the wanted
+    // top level fields of the payload are kept.
+    //---------------------------------
+    struct FeedMessage {
+        std::string             type;
+        std::vector<FieldValue> fields;     // Same order as the decoder wanted fields
+        double                  frameTs {};
+
+        const FieldValue &operator[](std::size_t index) const { return fields[index]; }
+    };
+
+    //---------------------------------
+    struct DecodeStats {
+        uint64_t    decoded {};     // Messages handed to the handler
+        uint64_t    skipped {};     // Not subscribed, never decoded
+    };
+
+    // Event driven decoder for stream frames:
+    //   {"ts": ..., "data": [["type", {payload}], ...]}
+    // No DOM is built; message and field buffers are reused, so steady
+    // state decoding does not allocate per value.
+    // With subscriptions, each message type is read from the first bytes
+    // of its element and only subscribed ones are decoded.
+    // Two backends share the handler: nlohmann SAX (validating), and a
+    // SIMD structural index + tape (faster; checks structure, not values).
+    //---------------------------------
+    class FeedDecoder {
+        public:
+            using Json           = nlohmann::json;
+            using MessageHandler = std::function<void(const FeedMessage &)>;
+
+            enum class Backend : uint8_t {
+                Sax,
+                Tape,
+            };
+
+            static constexpr std::size_t kNoField = std::size_t(-1);
+
+        public:
+            explicit    FeedDecoder(std::vector<std::string> wantedFields);
+
+            // Index into FeedMessage::fields, kNoField if not wanted
+            std::size_t fieldIndex(std::string_view name) const;
+
+            // Message types to decode; none means all of them
+            void        subscribe(std::vector<std::string> types) { mSubscribed = std::move(types); }
+
+            bool        isSubscribed(std::string_view type) const;
+
+            void        setBackend(Backend backend) { mBackend = backend; }
+            Backend     getBackend() const          { return mBackend; }
+
+            // Tape backend internals, for benchmarks
+            JsonTape   &getTape()                   { return mTape; }
+
+            // handler runs once per message, in frame order. False if the
+            // frame is not valid JSON; messages before the error were delivered.
+            bool        decode(std::string_view frame, const MessageHandler &handler);
+
+            const std::string &getLastError() const { return mLastError; }
+
+            const DecodeStats &getStats() const     { return mStats; }
+
+        protected:
+            class Sax;
+            friend class Sax;
+
+            enum class TopKey : uint8_t {
+                Other,
+                Ts,
+                Data,
+            };
+
+        protected:
+            bool        decodeElement(std::string_view element);
+
+            bool        decodeTape(std::string_view frame);
+
+            void        decodeTapeMessage(std::size_t element);
+
+            void        beginMessage();
+
+            void        setField(FieldValue::Kind kind);
+
+        protected:
+            std::vector<std::string>    mWantedFields;
+            std::vector<std::string>    mSubscribed;
+            Backend                     mBackend { Backend::Sax };
+            JsonTape                    mTape;
+            DecodeStats                 mStats;
+            FeedMessage                 mMessage;
+            const MessageHandler        *mHandler {};
+            std::string                 mLastError;
+            std::size_t                 mDepth {};
+            std::size_t                 mField { kNoField };
+            TopKey                      mTopKey {};
+            bool                        mInData {};
+            bool                        mInMessage {};
+            bool                        mHasType {};
+    };
+
+} // end of namespace
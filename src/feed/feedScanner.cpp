@@ -0,0 +1,120 @@
+#include "feedScanner.h"
+//--
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+//-------------------------------------
+namespace Molly {
+
+    //---------------------------------
+    const char *
+    FeedScanner::skipString(const char *begin, const char *end) {
+        const char *p = begin + 1;
+        for (;;) {
+            p = static_cast<const char *>(std::memchr(p, '"', std::size_t(end - p)));
+            if (p == nullptr) {
+                return nullptr;
+            }
+
+            // An odd run of backslashes escapes the quote
+            const char *slash = p;
+            while (slash > begin + 1 && slash[-1] == '\\') {
+                --slash;
+            }
+            ++p;
+            if (((p - 1 - slash) & 1) == 0) {
+                return p;
+            }
+        }
+    }
+
+    //---------------------------------
+    const char *
+    FeedScanner::skipValue(const char *begin, const char *end) {
+        const char *p = begin;
+        if (p >= end) {
+            return nullptr;
+        }
+
+        if (*p == '"') {
+            return skipString(p, end);
+        }
+
+        if (*p != '{' && *p != '[') {
+            while (p < end && *p != ',' && *p != ']' && *p != '}' && *p != ' ' && *p != '\n' && *p != '\r' && *p != '\t') {
+                ++p;
+            }
+            return p;
+        }
+
+        std::size_t depth = 0;
+        while (p < end) {
+            switch (*p) {
+                case '"':
+                    p = skipString(p, end);
+                    if (p == nullptr) {
+                        return nullptr;
+                    }
+                    continue;
+
+                case '{':
+                case '[':
+                    ++depth;
+                    break;
+
+                case '}':
+                case ']':
+                    if (--depth == 0) {
+                        return p + 1;
+                    }
+                    break;
+
+                default:
+                    break;
+            }
+            ++p;
+        }
+        return nullptr;
+    }
+
+    // Leaves p on the value
+    //---------------------------------
+    bool
+    FeedScanner::readTopKey(const char *&p, const char *end, std::string_view &key) {
+        p = skipSpaces(p, end);
+        if (p == end || *p != '"') {
+            return false;
+        }
+
+        const char *keyEnd = skipString(p, end);
+        if (keyEnd == nullptr) {
+            return false;
+        }
+        key = std::string_view(p + 1, std::size_t(keyEnd - p - 2));
+
+        p = skipSpaces(keyEnd, end);
+        if (p == end || *p != ':') {
+            return false;
+        }
+        p = skipSpaces(p + 1, end);
+        return p < end;
+    }
+
+    //---------------------------------
+    const char *
+    FeedScanner::readNumber(const char *begin, const char *end, double &value) {
+        const char *p = skipValue(begin, end);
+        if (p == nullptr) {
+            return nullptr;
+        }
+
+        // strtod needs a terminator
+        char number[32] {};
+        const auto length = std::min(std::size_t(p - begin), sizeof(number) - 1);
+        std::memcpy(number, begin, length);
+        value = std::strtod(number, nullptr);
+        return p;
+    }
+
+} // end of namespace
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+//-------------------------------------
+namespace Molly {
+
+    // Structural walk over a stream frame without decoding values:
+    // finds each ["type", {payload}] element and its type tag from the
+    // first bytes, so uninteresting messages can be skipped whole.
+    // Only brackets, quotes and escapes are looked at; a skipped element
+    // is not validated.
+    //---------------------------------
+    class FeedScanner {
+        public:
+            struct Element {
+                std::string_view    type;   // Raw tag, no escapes expected
+                std::string_view    text;   // The whole element, brackets included
+            };
+
+        public:
+            // onElement(const Element &) runs in frame order. False if the
+            // frame is not shaped as {"ts": ..., "data": [[...], ...]}.
+            template <typename OnElement>
+            static bool scan(std::string_view frame, double &frameTs, OnElement &&onElement);
+
+            // End of the JSON value starting at begin, nullptr if unbalanced
+            static const char *skipValue(const char *begin, const char *end);
+
+            // End of the string whose opening quote is at begin
+            static const char *skipString(const char *begin, const char *end);
+
+            static const char *skipSpaces(const char *begin, const char *end) {
+                while (begin < end && (*begin == ' ' || *begin == '\n' || *begin == '\r' || *begin == '\t')) {
+                    ++begin;
+                }
+                return begin;
+            }
+
+        protected:
+            static bool readTopKey(const char *&p, const char *end, std::string_view &key);
+
+            static const char *readNumber(const char *begin, const char *end, double &value);
+    };
+
+    //---------------------------------
+    template <typename OnElement>
+    bool
+    FeedScanner::scan(std::string_view frame, double &frameTs, OnElement &&onElement) {
+        const char *p   = frame.data();
+        const char *end = p + frame.size();
+
+        p = skipSpaces(p, end);
+        if (p == end || *p != '{') {
+            return false;
+        }
+        ++p;
+
+        std::string_view key;
+        while (readTopKey(p, end, key)) {
+            if (key == "ts") {
+                p = readNumber(p, end, frameTs);
+            }
+            else if (key == "data" && *p == '[') {
+                p = skipSpaces(p + 1, end);
+                while (p < end && *p == '[') {
+                    const char *element = p;
+                    const char *tag     = skipSpaces(p + 1, end);
+                    p = skipValue(element, end);
+                    if (p == nullptr) {
+                        return false;
+                    }
+
+                    Element found;
+                    found.text = std::string_view(element, std::size_t(p - element));
+                    if (tag < p && *tag == '"') {
+                        const char *tagEnd = skipString(tag, p);
+                        if (tagEnd != nullptr) {
+                            found.type = std::string_view(tag + 1, std::size_t(tagEnd - tag - 2));
+                        }
+                    }
+                    onElement(found);
+
+                    p = skipSpaces(p, end);
+                    if (p < end && *p == ',') {
+                        p = skipSpaces(p + 1, end);
+                    }
+                }
+                if (p == end || *p != ']') {
+                    return false;
+                }
+                ++p;
+            }
+            else {
+                p = skipValue(p, end);
+            }
+
+            if (p == nullptr) {
+                return false;
+            }
+            p = skipSpaces(p, end);
+            if (p < end && *p == ',') {
+                ++p;
+            }
+        }
+        return p < end && *p == '}';
+    }
+
+} // end of namespace
@@ -0,0 +1,137 @@
+#include "incrementalScanner.h"
+//--
+#include <cstring>
+
+//-------------------------------------
+namespace Molly {
+
+    static constexpr int         kMaxDepth    = 64;
+    static constexpr std::size_t kMaxKeyBytes = 16;     // Longer keys are not "data" anyway
+
+    //---------------------------------
+    const char *
+    IncrementalScanner::advance(const char *p, const char *end) {
+        while (p < end) {
+            if (mInString && mKeyString == false) {
+                // Values: jump to the closing quote, stopping at escapes
+                if (mEscaped) {
+                    mEscaped = false;
+                    ++p;
+                    continue;
+                }
+                const char *quote     = static_cast<const char *>(std::memchr(p, '"', std::size_t(end - p)));
+                const char *limit     = quote != nullptr ? quote : end;
+                const char *backslash = static_cast<const char *>(std::memchr(p, '\\', std::size_t(limit - p)));
+                if (backslash != nullptr) {
+                    mEscaped = true;
+                    p = backslash + 1;
+                }
+                else {
+                    mInString = quote == nullptr;
+                    p = quote != nullptr ? quote + 1 : end;
+                }
+                continue;
+            }
+
+            const char c = *p++;
+
+            if (mInString) {
+                if (mEscaped) {
+                    mEscaped = false;
+                }
+                else if (c == '\\') {
+                    mEscaped = true;
+                }
+                else if (c == '"') {
+                    mInString = false;
+                }
+                else if (mKey.size() < kMaxKeyBytes) {
+                    mKey += c;
+                }
+                continue;
+            }
+
+            switch (c) {
+                case '"':
+                    mInString  = true;
+                    mKeyString = mDepth == 1 && mExpectKey;
+                    if (mKeyString) {
+                        mKey.clear();
+                    }
+                    break;
+
+                case '{':
+                case '[':
+                    if (mDepth == 0) {
+                        mFailed    = c != '{';
+                        mExpectKey = true;
+                    }
+                    else if (mDepth == 1 && c == '[' && mKey == "data") {
+                        mInData = true;
+                    }
+                    else if (mDepth == 2 && mInData && c == '[') {
+                        mInElement = true;
+                        mBegin     = p - 1;
+                    }
+                    if (++mDepth > kMaxDepth) {
+                        mFailed = true;
+                    }
+                    if (mFailed) {
+                        return end;
+                    }
+                    break;
+
+                case '}':
+                case ']':
+                    if (--mDepth < 0) {
+                        mFailed = true;
+                        return end;
+                    }
+                    if (mDepth == 2 && mInElement) {
+                        mInElement = false;
+                        mClosed    = true;
+                        return p;
+                    }
+                    if (mDepth == 1) {
+                        mInData = false;
+                    }
+                    break;
+
+                case ':':
+                    if (mDepth == 1) {
+                        mExpectKey = false;
+                    }
+                    break;
+
+                case ',':
+                    if (mDepth == 1) {
+                        mExpectKey = true;
+                    }
+                    break;
+
+                default:
+                    break;
+            }
+        }
+        return p;
+    }
+
+    //---------------------------------
+    bool
+    IncrementalScanner::finish() {
+        const bool ok = mFailed == false && mDepth == 0 && mInString == false;
+
+        mPending.clear();
+        mKey.clear();
+        mDepth     = 0;
+        mInString  = false;
+        mEscaped   = false;
+        mExpectKey = false;
+        mKeyString = false;
+        mInData    = false;
+        mInElement = false;
+        mFailed    = false;
+        return ok;
+    }
+
+} // end of namespace
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+//-------------------------------------
+namespace Molly {
+
+    // Resumable FeedScanner: takes a frame in fragments, as they come off
+    // the socket, and emits each ["type", {payload}] element of the "data"
+    // array as soon as its closing bracket arrives. Elements within one
+    // fragment are passed in place; only those split across fragments are
+    // copied. Like FeedScanner, nothing but brackets, quotes and escapes
+    // is looked at.
+    //---------------------------------
+    class IncrementalScanner {
+        public:
+            // Next fragment of the current frame. onElement(std::string_view)
+            // runs for every element completed by it. False once the frame
+            // is known to be malformed; the rest of it is then ignored.
+            template <typename OnElement>
+            bool        feed(std::string_view fragment, OnElement &&onElement);
+
+            // After the last fragment: false if the frame was malformed or
+            // truncated. Gets ready for the next frame either way.
+            bool        finish();
+
+            uint64_t    getElements() const     { return mElements; }
+            uint64_t    getCopiedBytes() const  { return mCopiedBytes; }
+
+        protected:
+            // Consumes up to the end of an element or of the fragment,
+            // returns where it stopped
+            const char *advance(const char *p, const char *end);
+
+        protected:
+            std::string mPending;           // Element split across fragments
+            std::string mKey;               // Last key of the frame object
+            const char  *mBegin {};         // Element opened by the last advance()
+            int         mDepth {};
+            bool        mInString {};
+            bool        mEscaped {};
+            bool        mExpectKey {};      // Next string at depth 1 is a key
+            bool        mKeyString {};      // Current string is that key
+            bool        mInData {};         // Inside the "data" array
+            bool        mInElement {};
+            bool        mClosed {};         // Element closed by the last advance()
+            bool        mFailed {};
+            uint64_t    mElements {};
+            uint64_t    mCopiedBytes {};
+    };
+
+    //---------------------------------
+    template <typename OnElement>
+    bool
+    IncrementalScanner::feed(std::string_view fragment, OnElement &&onElement) {
+        const char *p   = fragment.data();
+        const char *end = p + fragment.size();
+        while (p < end && mFailed == false) {
+            const bool  carried = mInElement;   // Its first bytes are in mPending
+            const char *start   = p;
+            mBegin = nullptr;
+            p = advance(p, end);
+
+            if (mClosed) {
+                mClosed = false;
+                ++mElements;
+                if (carried) {
+                    mPending.append(start, std::size_t(p - start));
+                    mCopiedBytes += std::size_t(p - start);
+                    onElement(std::string_view(mPending));
+                    mPending.clear();
+                }
+                else {
+                    onElement(std::string_view(mBegin, std::size_t(p - mBegin)));
+                }
+            }
+            else if (mInElement) {
+                const char *from = carried ? start : mBegin;
+                mPending.append(from, std::size_t(p - from));
+                mCopiedBytes += std::size_t(p - from);
+            }
+        }
+        return mFailed == false;
+    }
+
+} // end of namespace
@@ -0,0 +1,340 @@
+#include "jsonTape.h"
+//--
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+//-------------------------------------
+namespace Molly {
+
+    // -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+    //---------------------------------
+    static bool
+    isNumber(std::string_view text) {
+        const auto digits = [&](std::size_t &i) {
+            const auto start = i;
+            while (i < text.size() && text[i] >= '0' && text[i] <= '9') {
+                ++i;
+            }
+            return i > start;
+        };
+
+        std::size_t i = text.size() != 0 && text[0] == '-';
+        if (i < text.size() && text[i] == '0') {
+            ++i;
+        }
+        else if (digits(i) == false) {
+            return false;
+        }
+        if (i < text.size() && text[i] == '.' && digits(++i) == false) {
+            return false;
+        }
+        if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+            ++i;
+            if (i < text.size() && (text[i] == '+' || text[i] == '-')) {
+                ++i;
+            }
+            if (digits(i) == false) {
+                return false;
+            }
+        }
+        return i == text.size();
+    }
+
+    //---------------------------------
+    bool
+    JsonTape::parse(std::string_view json) {
+        mJson  = json;
+        mPos   = 0;
+        mError = nullptr;
+        mNodes.clear();
+
+        if (mIndex.build(json) == false) {
+            return fail("unterminated string");
+        }
+        if (mIndex.size() == 0) {
+            return fail("empty document");
+        }
+        if (parseValue(0) == false) {
+            return false;
+        }
+        if (mPos != mIndex.size()) {
+            return fail("trailing characters");
+        }
+        return true;
+    }
+
+    //---------------------------------
+    bool
+    JsonTape::parseValue(std::size_t depth) {
+        if (mPos >= mIndex.size()) {
+            return fail("unexpected end");
+        }
+        if (depth >= kMaxDepth) {
+            return fail("too deep");
+        }
+
+        const uint32_t    offset = mIndex[mPos];
+        const std::size_t node   = mNodes.size();
+        const char        c      = mJson[offset];
+
+        switch (c) {
+            case '{':
+            case '[': {
+                const bool  isObject = c == '{';
+                const char  close    = isObject ? '}' : ']';
+                mNodes.push_back({ isObject ? Kind::Object : Kind::Array, offset, 0, 0 });
+                ++mPos;
+
+                if (mPos < mIndex.size() && mJson[mIndex[mPos]] == close) {
+                    ++mPos;
+                }
+                else {
+                    for (;;) {
+                        if (isObject) {
+                            if (mPos >= mIndex.size() || mJson[mIndex[mPos]] != '"') {
+                                return fail("expected key");
+                            }
+                            if (parseValue(depth + 1) == false) {
+                                return false;
+                            }
+                            if (mPos >= mIndex.size() || mJson[mIndex[mPos]] != ':') {
+                                return fail("expected ':'");
+                            }
+                            ++mPos;
+                        }
+                        if (parseValue(depth + 1) == false) {
+                            return false;
+                        }
+                        if (mPos >= mIndex.size()) {
+                            return fail("unexpected end");
+                        }
+
+                        const char separator = mJson[mIndex[mPos++]];
+                        if (separator == close) {
+                            break;
+                        }
+                        if (separator != ',') {
+                            return fail("expected ',' or closing bracket");
+                        }
+                    }
+                }
+                mNodes[node].end  = mIndex[mPos - 1] + 1;
+                mNodes[node].next = uint32_t(mNodes.size());
+                return true;
+            }
+
+            case '"': {
+                // The index holds both quotes of every string
+                if (mPos + 1 >= mIndex.size()) {
+                    return fail("unterminated string");
+                }
+                mNodes.push_back({ Kind::String, offset + 1, mIndex[mPos + 1], uint32_t(node + 1) });
+                mPos += 2;
+                return true;
+            }
+
+            case '}':
+            case ']':
+            case ':':
+            case ',':
+                return fail("unexpected character");
+
+            default:
+                break;
+        }
+
+        // Scalars end at the next structural character or space
+        uint32_t end = mPos + 1 < mIndex.size() ? mIndex[mPos + 1] : uint32_t(mJson.size());
+        while (end > offset && (mJson[end - 1] == ' ' || mJson[end - 1] == '\n' || mJson[end - 1] == '\r' || mJson[end - 1] == '\t')) {
+            --end;
+        }
+        const std::string_view text = mJson.substr(offset, end - offset);
+
+        Kind kind;
+        if (text == "true") {
+            kind = Kind::True;
+        }
+        else if (text == "false") {
+            kind = Kind::False;
+        }
+        else if (text == "null") {
+            kind = Kind::Null;
+        }
+        else if (isNumber(text)) {
+            kind = Kind::Number;
+        }
+        else {
+            return fail("invalid literal");
+        }
+
+        mNodes.push_back({ kind, offset, end, uint32_t(node + 1) });
+        ++mPos;
+        return true;
+    }
+
+    //---------------------------------
+    std::string_view
+    JsonTape::raw(std::size_t i) const {
+        const auto &node = mNodes[i];
+        return mJson.substr(node.begin, node.end - node.begin);
+    }
+
+    //---------------------------------
+    bool
+    JsonTape::getString(std::size_t i, std::string &out) const {
+        out.clear();
+        if (mNodes[i].kind != Kind::String) {
+            return false;
+        }
+
+        const auto text = raw(i);
+        if (text.find('\\') == std::string_view::npos) {
+            out.assign(text);
+            return true;
+        }
+        return unescape(text, out);
+    }
+
+    //---------------------------------
+    bool
+    JsonTape::isInteger(std::size_t i) const {
+        return mNodes[i].kind == Kind::Number && raw(i).find_first_of(".eE") == std::string_view::npos;
+    }
+
+    //---------------------------------
+    bool
+    JsonTape::getInteger(std::size_t i, int64_t &out) const {
+        if (isInteger(i) == false) {
+            return false;
+        }
+
+        const auto text     = raw(i);
+        const bool negative = text[0] == '-';
+        uint64_t   value    = 0;
+        for (std::size_t j = negative; j < text.size(); ++j) {
+            const unsigned digit = unsigned(text[j] - '0');
+            if (digit > 9 || value > (uint64_t(INT64_MAX) - digit) / 10) {
+                return false;
+            }
+            value = value * 10 + digit;
+        }
+        out = negative ? -int64_t(value) : int64_t(value);
+        return text.size() > std::size_t(negative);
+    }
+
+    //---------------------------------
+    bool
+    JsonTape::getNumber(std::size_t i, double &out) const {
+        if (mNodes[i].kind != Kind::Number) {
+            return false;
+        }
+
+        // strtod needs a terminator
+        const auto text = raw(i);
+        char number[64];
+        if (text.size() >= sizeof(number)) {
+            return false;
+        }
+        std::memcpy(number, text.data(), text.size());
+        number[text.size()] = 0;
+
+        char *end;
+        out = std::strtod(number, &end);
+        return end == number + text.size();
+    }
+
+    //---------------------------------
+    static void
+    appendUTF8(uint32_t code, std::string &out) {
+        if (code < 0x80) {
+            out += char(code);
+        }
+        else if (code < 0x800) {
+            out += char(0xC0 | (code >> 6));
+            out += char(0x80 | (code & 0x3F));
+        }
+        else if (code < 0x10000) {
+            out += char(0xE0 | (code >> 12));
+            out += char(0x80 | ((code >> 6) & 0x3F));
+            out += char(0x80 | (code & 0x3F));
+        }
+        else {
+            out += char(0xF0 | (code >> 18));
+            out += char(0x80 | ((code >> 12) & 0x3F));
+            out += char(0x80 | ((code >> 6) & 0x3F));
+            out += char(0x80 | (code & 0x3F));
+        }
+    }
+
+    //---------------------------------
+    static bool
+    readHex4(std::string_view text, std::size_t pos, uint32_t &code) {
+        if (pos + 4 > text.size()) {
+            return false;
+        }
+        code = 0;
+        for (std::size_t i = pos; i < pos + 4; ++i) {
+            const char c = text[i];
+            code <<= 4;
+            if (c >= '0' && c <= '9')       code |= uint32_t(c - '0');
+            else if (c >= 'a' && c <= 'f')  code |= uint32_t(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F')  code |= uint32_t(c - 'A' + 10);
+            else                            return false;
+        }
+        return true;
+    }
+
+    //---------------------------------
+    bool
+    JsonTape::unescape(std::string_view raw, std::string &out) {
+        for (std::size_t i = 0; i < raw.size(); ++i) {
+            const char c = raw[i];
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (++i == raw.size()) {
+                return false;
+            }
+
+            switch (raw[i]) {
+                case '"':  out += '"';  break;
+                case '\\': out += '\\'; break;
+                case '/':  out += '/';  break;
+                case 'b':  out += '\b'; break;
+                case 'f':  out += '\f'; break;
+                case 'n':  out += '\n'; break;
+                case 'r':  out += '\r'; break;
+                case 't':  out += '\t'; break;
+                case 'u': {
+                    uint32_t code;
+                    if (readHex4(raw, i + 1, code) == false) {
+                        return false;
+                    }
+                    i += 4;
+
+                    // Surrogate pair: \uD8xx\uDCxx
+                    if (code >= 0xD800 && code <= 0xDBFF) {
+                        uint32_t low;
+                        if (i + 2 >= raw.size() || raw[i + 1] != '\\' || raw[i + 2] != 'u' ||
+                            readHex4(raw, i + 3, low) == false || low < 0xDC00 || low > 0xDFFF) {
+                            return false;
+                        }
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    }
+                    else if (code >= 0xDC00 && code <= 0xDFFF) {
+                        return false;
+                    }
+                    appendUTF8(code, out);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        return true;
+    }
+
+} // end of namespace
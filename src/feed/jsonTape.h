@@ -0,0 +1,81 @@
+#pragma once
+
+#include "structuralIndex.h"
+//--
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//-------------------------------------
+namespace Molly {
+
+    // Second stage: walks the structural index once and lays the values
+    // out as a flat tape, in document order. Nothing is decoded here;
+    // strings and numbers are read from the input on demand, and every
+    // node knows where its next sibling is, so subtrees skip in O(1).
+    // The input must outlive the tape.
+    //---------------------------------
+    class JsonTape {
+        public:
+            enum class Kind : uint8_t {
+                Object,
+                Array,
+                String,
+                Number,
+                True,
+                False,
+                Null,
+            };
+
+            struct Node {
+                Kind        kind;
+                uint32_t    begin;      // String: after the quote. Containers: the bracket.
+                uint32_t    end;        // String: closing quote. Scalars: one past the text.
+                uint32_t    next;       // Next sibling node
+            };
+
+            static constexpr std::size_t kMaxDepth = 64;
+
+        public:
+            // False (see getError) if the input is not well formed
+            bool            parse(std::string_view json);
+
+            const Node     &operator[](std::size_t i) const    { return mNodes[i]; }
+            std::size_t     size() const                        { return mNodes.size(); }
+
+            // Children of a container run from first() to its next, stepping
+            // with next. In objects they alternate key, value.
+            static std::size_t first(std::size_t i)             { return i + 1; }
+            std::size_t     next(std::size_t i) const           { return mNodes[i].next; }
+            std::size_t     end(std::size_t i) const            { return mNodes[i].next; }
+
+            // Raw text: escapes are not resolved
+            std::string_view    raw(std::size_t i) const;
+
+            bool            getString(std::size_t i, std::string &out) const;
+            bool            getInteger(std::size_t i, int64_t &out) const;
+            bool            getNumber(std::size_t i, double &out) const;
+            bool            isInteger(std::size_t i) const;
+
+            const char     *getError() const                    { return mError; }
+
+            StructuralIndex &getIndex()                         { return mIndex; }
+
+            // Appends the UTF-8 text of a JSON string body
+            static bool     unescape(std::string_view raw, std::string &out);
+
+        protected:
+            bool            parseValue(std::size_t depth);
+
+            bool            fail(const char *error)             { mError = error; return false; }
+
+        protected:
+            StructuralIndex     mIndex;
+            std::vector<Node>   mNodes;
+            std::string_view    mJson;
+            std::size_t         mPos {};        // Next index entry
+            const char          *mError {};
+    };
+
+} // end of namespace
@@ -0,0 +1,18 @@
+#pragma once
+
+// Internal to the feed kernels: include from .cpp files only. On x86,
+// kStructuralX86 is defined and functions marked kTargetSSE42/kTargetAVX2
+// may use those instructions; callers pick them at runtime through
+// StructuralIndex::detect().
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define kStructuralX86
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+        #define kTargetSSE42
+        #define kTargetAVX2
+    #else
+        #define kTargetSSE42    __attribute__((target("sse4.2")))
+        #define kTargetAVX2     __attribute__((target("avx2")))
+    #endif
+#endif
@@ -0,0 +1,243 @@
+#include "structuralIndex.h"
+#include "simdTarget.h"
+//--
+#include <cstring>
+
+//-------------------------------------
+namespace Molly {
+
+    // One bit per byte of a 64 byte block
+    //---------------------------------
+    struct BlockMasks {
+        uint64_t    quote;
+        uint64_t    backslash;
+        uint64_t    op;         // { } [ ] : ,
+        uint64_t    space;
+    };
+
+    constexpr std::size_t kBlockBytes = 64;
+
+    //---------------------------------
+    static inline unsigned
+    trailingZeros(uint64_t bits) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return unsigned(index);
+#else
+        return unsigned(__builtin_ctzll(bits));
+#endif
+    }
+
+    // Bit i set when an odd number of bits 0..i are set
+    //---------------------------------
+    static inline uint64_t
+    prefixXor(uint64_t bits) {
+        bits ^= bits << 1;
+        bits ^= bits << 2;
+        bits ^= bits << 4;
+        bits ^= bits << 8;
+        bits ^= bits << 16;
+        bits ^= bits << 32;
+        return bits;
+    }
+
+    //---------------------------------
+    static void
+    classifyScalar(const char *block, BlockMasks &masks) {
+        masks = {};
+        for (std::size_t i = 0; i < kBlockBytes; ++i) {
+            const uint64_t bit = uint64_t(1) << i;
+            switch (block[i]) {
+                case '"':  masks.quote     |= bit; break;
+                case '\\': masks.backslash |= bit; break;
+                case '{': case '}': case '[': case ']': case ':': case ',':
+                    masks.op |= bit;
+                    break;
+                case ' ': case '\t': case '\n': case '\r':
+                    masks.space |= bit;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+#if defined(kStructuralX86)
+    // '[' | 0x20 == '{' and ']' | 0x20 == '}': brackets take two compares
+    //---------------------------------
+    kTargetSSE42 static void
+    classifySSE42(const char *block, BlockMasks &masks) {
+        const __m128i quote     = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i lower     = _mm_set1_epi8(0x20);
+        const __m128i open      = _mm_set1_epi8('{');
+        const __m128i close     = _mm_set1_epi8('}');
+        const __m128i colon     = _mm_set1_epi8(':');
+        const __m128i comma     = _mm_set1_epi8(',');
+        const __m128i space     = _mm_set1_epi8(' ');
+        const __m128i tab       = _mm_set1_epi8('\t');
+        const __m128i lf        = _mm_set1_epi8('\n');
+        const __m128i cr        = _mm_set1_epi8('\r');
+
+        masks = {};
+        for (std::size_t i = 0; i < kBlockBytes; i += 16) {
+            const __m128i chars  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i));
+            const __m128i folded = _mm_or_si128(chars, lower);
+            const __m128i op     = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, open), _mm_cmpeq_epi8(folded, close)),
+                                                _mm_or_si128(_mm_cmpeq_epi8(chars, colon), _mm_cmpeq_epi8(chars, comma)));
+            const __m128i ws     = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chars, space), _mm_cmpeq_epi8(chars, tab)),
+                                                _mm_or_si128(_mm_cmpeq_epi8(chars, lf), _mm_cmpeq_epi8(chars, cr)));
+
+            masks.quote     |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(chars, quote)))) << i;
+            masks.backslash |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(chars, backslash)))) << i;
+            masks.op        |= uint64_t(uint16_t(_mm_movemask_epi8(op))) << i;
+            masks.space     |= uint64_t(uint16_t(_mm_movemask_epi8(ws))) << i;
+        }
+    }
+
+    //---------------------------------
+    kTargetAVX2 static void
+    classifyAVX2(const char *block, BlockMasks &masks) {
+        const __m256i quote     = _mm256_set1_epi8('"');
+        const __m256i backslash = _mm256_set1_epi8('\\');
+        const __m256i lower     = _mm256_set1_epi8(0x20);
+        const __m256i open      = _mm256_set1_epi8('{');
+        const __m256i close     = _mm256_set1_epi8('}');
+        const __m256i colon     = _mm256_set1_epi8(':');
+        const __m256i comma     = _mm256_set1_epi8(',');
+        const __m256i space     = _mm256_set1_epi8(' ');
+        const __m256i tab       = _mm256_set1_epi8('\t');
+        const __m256i lf        = _mm256_set1_epi8('\n');
+        const __m256i cr        = _mm256_set1_epi8('\r');
+
+        masks = {};
+        for (std::size_t i = 0; i < kBlockBytes; i += 32) {
+            const __m256i chars  = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + i));
+            const __m256i folded = _mm256_or_si256(chars, lower);
+            const __m256i op     = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(folded, open), _mm256_cmpeq_epi8(folded, close)),
+                                                   _mm256_or_si256(_mm256_cmpeq_epi8(chars, colon), _mm256_cmpeq_epi8(chars, comma)));
+            const __m256i ws     = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chars, space), _mm256_cmpeq_epi8(chars, tab)),
+                                                   _mm256_or_si256(_mm256_cmpeq_epi8(chars, lf), _mm256_cmpeq_epi8(chars, cr)));
+
+            masks.quote     |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, quote)))) << i;
+            masks.backslash |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, backslash)))) << i;
+            masks.op        |= uint64_t(uint32_t(_mm256_movemask_epi8(op))) << i;
+            masks.space     |= uint64_t(uint32_t(_mm256_movemask_epi8(ws))) << i;
+        }
+    }
+#endif
+
+    //---------------------------------
+    StructuralIndex::StructuralIndex()
+        : mIsa(detect())
+    {
+    }
+
+    //---------------------------------
+    StructuralIndex::Isa
+    StructuralIndex::detect() {
+        static const Isa isa = []() {
+#if defined(kStructuralX86) && defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 1);
+            const bool sse42   = (info[2] & (1 << 20)) != 0;
+            const bool osAVX   = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+            __cpuidex(info, 7, 0);
+            const bool avx2    = osAVX && (info[1] & (1 << 5)) != 0;
+            return avx2 ? Isa::AVX2 : sse42 ? Isa::SSE42 : Isa::Scalar;
+#elif defined(kStructuralX86)
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") ? Isa::AVX2 : __builtin_cpu_supports("sse4.2") ? Isa::SSE42 : Isa::Scalar;
+#else
+            return Isa::Scalar;
+#endif
+        }();
+        return isa;
+    }
+
+    //---------------------------------
+    const char *
+    StructuralIndex::getName(Isa isa) {
+        switch (isa) {
+            case Isa::AVX2:     return "AVX2";
+            case Isa::SSE42:    return "SSE4.2";
+            default:            return "scalar";
+        }
+    }
+
+    //---------------------------------
+    bool
+    StructuralIndex::build(std::string_view json) {
+        void (*classify)(const char *, BlockMasks &) = classifyScalar;
+#if defined(kStructuralX86)
+        if (mIsa == Isa::AVX2) {
+            classify = classifyAVX2;
+        }
+        else if (mIsa == Isa::SSE42) {
+            classify = classifySSE42;
+        }
+#endif
+
+        // At most one position per byte, plus a block of slack for the flattening
+        if (mPositions.size() < json.size() + kBlockBytes) {
+            mPositions.resize(json.size() + kBlockBytes);
+        }
+        uint32_t *out = mPositions.data();
+
+        uint64_t inString   = 0;    // All ones when the previous block ended inside a string
+        uint64_t escapeNext = 0;    // 1 when its last byte was an unescaped backslash
+        uint64_t boundary   = 1;    // 1 when its last byte ends a token (so does the start)
+
+        char tail[kBlockBytes];
+        for (std::size_t base = 0; base < json.size(); base += kBlockBytes) {
+            const char *block = json.data() + base;
+            if (json.size() - base < kBlockBytes) {
+                std::memset(tail, ' ', sizeof(tail));
+                std::memcpy(tail, block, json.size() - base);
+                block = tail;
+            }
+
+            BlockMasks masks;
+            classify(block, masks);
+
+            // Escapes are rare: walk the backslashes one by one
+            uint64_t escaped = escapeNext;
+            escapeNext = 0;
+            uint64_t backslash = masks.backslash & ~escaped;
+            while (backslash != 0) {
+                const unsigned bit = trailingZeros(backslash);
+                if (bit == 63) {
+                    escapeNext = 1;
+                    break;
+                }
+                escaped   |= uint64_t(1) << (bit + 1);
+                backslash &= ~(uint64_t(3) << bit);
+            }
+
+            const uint64_t quote   = masks.quote & ~escaped;
+            const uint64_t strings = prefixXor(quote) ^ inString;  // Opening quote in, closing one out
+            inString = uint64_t(int64_t(strings) >> 63);
+
+            // A closing quote ends a token too, so `"a"x` indexes the x and
+            // the parser sees what follows a string
+            const uint64_t op       = masks.op & ~strings;
+            const uint64_t scalar   = ~(masks.op | masks.space | quote | strings);
+            const uint64_t ends     = (masks.op | masks.space | quote) & ~strings;
+            const uint64_t starts   = scalar & ((ends << 1) | boundary);
+            boundary = ends >> 63;
+
+            uint64_t structural = op | quote | starts;
+            const uint32_t offset = uint32_t(base);
+            while (structural != 0) {
+                *out++ = offset + trailingZeros(structural);
+                structural &= structural - 1;
+            }
+        }
+
+        mCount = std::size_t(out - mPositions.data());
+        // Tail padding spaces are never structural, so nothing to trim
+        return inString == 0;
+    }
+
+} // end of namespace
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+//-------------------------------------
+namespace Molly {
+
+    // First stage of a simdjson style parser: classifies the input 64
+    // bytes at a time with SIMD compares and records the offset of every
+    // structural character outside strings ({ } [ ] : ,), every unescaped
+    // quote and the first byte of every other scalar.
+    // The kernel is picked at run time (AVX2, SSE4.2, scalar).
+    //---------------------------------
+    class StructuralIndex {
+        public:
+            enum class Isa : uint8_t {
+                Scalar,
+                SSE42,
+                AVX2,
+            };
+
+        public:
+                        StructuralIndex();
+
+            // False on an unterminated string
+            bool        build(std::string_view json);
+
+            const uint32_t *begin() const   { return mPositions.data(); }
+            const uint32_t *end() const     { return mPositions.data() + mCount; }
+            std::size_t     size() const    { return mCount; }
+            uint32_t        operator[](std::size_t i) const { return mPositions[i]; }
+
+            // Best kernel this CPU supports
+            static Isa          detect();
+            static const char  *getName(Isa isa);
+
+            // Benchmarks only: downgrading is fine, upgrading is ignored
+            void        setIsa(Isa isa)     { mIsa = isa <= detect() ? isa : detect(); }
+            Isa         getIsa() const      { return mIsa; }
+
+        protected:
+            std::vector<uint32_t>   mPositions;     // Only the first mCount are valid
+            std::size_t             mCount {};
+            Isa                     mIsa;
+    };
+
+} // end of namespace
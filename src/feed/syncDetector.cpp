@@ -0,0 +1,145 @@
+#include "syncDetector.h"
+#include "simdTarget.h"
+#include "feedScanner.h"
+//--
+#include <cstring>
+
+//-------------------------------------
+namespace Molly {
+
+    static constexpr char        kPattern[]    = "\"sync\"";
+    static constexpr std::size_t kPatternBytes = sizeof(kPattern) - 1;
+
+    //---------------------------------
+    static inline bool
+    matchAt(const char *text) {
+        return std::memcmp(text, kPattern, kPatternBytes) == 0;
+    }
+
+    //---------------------------------
+    static inline unsigned
+    trailingZeros(uint32_t bits) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, bits);
+        return unsigned(index);
+#else
+        return unsigned(__builtin_ctz(bits));
+#endif
+    }
+
+    //---------------------------------
+    static bool
+    hasCandidateScalar(const char *text, std::size_t size) {
+        const char *end = text + size;
+        while (std::size_t(end - text) >= kPatternBytes) {
+            text = static_cast<const char *>(std::memchr(text, '"', std::size_t(end - text) - kPatternBytes + 1));
+            if (text == nullptr) {
+                return false;
+            }
+            if (matchAt(text)) {
+                return true;
+            }
+            ++text;
+        }
+        return false;
+    }
+
+#if defined(kStructuralX86)
+    // Bytes 0, 1 and 5 of the pattern ("s...") are compared for a whole
+    // vector of positions at once; the few survivors are checked in full
+    //---------------------------------
+    kTargetSSE42 static bool
+    hasCandidateSSE42(const char *text, std::size_t size) {
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i s     = _mm_set1_epi8('s');
+
+        std::size_t i = 0;
+        for (; i + 16 + kPatternBytes - 1 <= size; i += 16) {
+            const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+            const __m128i next  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i + 1));
+            const __m128i last  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i + kPatternBytes - 1));
+            const __m128i hits  = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(first, quote), _mm_cmpeq_epi8(next, s)), _mm_cmpeq_epi8(last, quote));
+
+            uint32_t mask = uint32_t(_mm_movemask_epi8(hits));
+            while (mask != 0) {
+                if (matchAt(text + i + trailingZeros(mask))) {
+                    return true;
+                }
+                mask &= mask - 1;
+            }
+        }
+        return hasCandidateScalar(text + i, size - i);
+    }
+
+    //---------------------------------
+    kTargetAVX2 static bool
+    hasCandidateAVX2(const char *text, std::size_t size) {
+        const __m256i quote = _mm256_set1_epi8('"');
+        const __m256i s     = _mm256_set1_epi8('s');
+
+        std::size_t i = 0;
+        for (; i + 32 + kPatternBytes - 1 <= size; i += 32) {
+            const __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i));
+            const __m256i next  = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i + 1));
+            const __m256i last  = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i + kPatternBytes - 1));
+            const __m256i hits  = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(first, quote), _mm256_cmpeq_epi8(next, s)), _mm256_cmpeq_epi8(last, quote));
+
+            uint32_t mask = uint32_t(_mm256_movemask_epi8(hits));
+            while (mask != 0) {
+                if (matchAt(text + i + trailingZeros(mask))) {
+                    return true;
+                }
+                mask &= mask - 1;
+            }
+        }
+        return hasCandidateScalar(text + i, size - i);
+    }
+#endif
+
+    //---------------------------------
+    SyncDetector::SyncDetector()
+        : mIsa(StructuralIndex::detect())
+    {
+    }
+
+    //---------------------------------
+    bool
+    SyncDetector::hasCandidate(std::string_view text, Isa isa) {
+#if defined(kStructuralX86)
+        if (isa == Isa::AVX2) {
+            return hasCandidateAVX2(text.data(), text.size());
+        }
+        if (isa == Isa::SSE42) {
+            return hasCandidateSSE42(text.data(), text.size());
+        }
+#else
+        (void) isa;
+#endif
+        return hasCandidateScalar(text.data(), text.size());
+    }
+
+    //---------------------------------
+    std::size_t
+    SyncDetector::find(std::string_view frame) {
+        ++mStats.frames;
+        if (hasCandidate(frame, mIsa) == false) {
+            return kNotFound;
+        }
+        ++mStats.candidates;
+
+        std::size_t found = kNotFound;
+        double      frameTs {};
+        FeedScanner::scan(frame, frameTs, [&](const FeedScanner::Element &element) {
+            if (found == kNotFound && element.type == "sync") {
+                found = std::size_t(element.text.data() - frame.data());
+            }
+        });
+
+        if (found != kNotFound) {
+            ++mStats.found;
+        }
+        return found;
+    }
+
+} // end of namespace
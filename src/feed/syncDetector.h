@@ -0,0 +1,49 @@
+#pragma once
+
+#include "structuralIndex.h"
+//--
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+//-------------------------------------
+namespace Molly {
+
+    //---------------------------------
+    struct SyncStats {
+        uint64_t    frames {};
+        uint64_t    candidates {};  // Frames holding the "sync" bytes
+        uint64_t    found {};       // Confirmed at a message type position
+    };
+
+    // Tells whether a stream frame holds a ["sync", {...}] message without
+    // parsing it. A SIMD scan looks for the "sync" bytes, which most frames
+    // do not have; frames that do are walked by FeedScanner, so only a tag
+    // at the message type position counts, never a value equal to "sync".
+    //---------------------------------
+    class SyncDetector {
+        public:
+            using Isa = StructuralIndex::Isa;
+
+            static constexpr std::size_t kNotFound = std::string_view::npos;
+
+        public:
+                        SyncDetector();
+
+            // Offset of the sync element (its '['), kNotFound if none
+            std::size_t find(std::string_view frame);
+
+            const SyncStats &getStats() const   { return mStats; }
+
+            // Benchmarks only, same rules as StructuralIndex::setIsa
+            void        setIsa(Isa isa)         { mIsa = isa <= StructuralIndex::detect() ? isa : StructuralIndex::detect(); }
+
+            // True when the "sync" bytes appear anywhere in text
+            static bool hasCandidate(std::string_view text, Isa isa);
+
+        protected:
+            SyncStats   mStats;
+            Isa         mIsa;
+    };
+
+} // end of namespace
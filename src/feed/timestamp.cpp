@@ -0,0 +1,237 @@
+#include "timestamp.h"
+#include "simdTarget.h"
+
+//-------------------------------------
+namespace Molly {
+
+    static constexpr std::size_t kDateTimeBytes = 19;   // YYYY-MM-DDTHH:MM:SS
+    static constexpr int64_t     kSecondsPerDay = 86400;
+    static constexpr int64_t     kMaxSeconds    = INT64_MAX / Timestamp::kNanosPerSecond;
+
+    static constexpr int64_t kPow10[10] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+    };
+
+    //---------------------------------
+    struct DateTime {
+        unsigned    year;
+        unsigned    month;
+        unsigned    day;
+        unsigned    hour;
+        unsigned    minute;
+        unsigned    second;
+    };
+
+    //---------------------------------
+    static inline unsigned
+    digitOf(char c) {
+        return unsigned(uint8_t(c) - uint8_t('0'));
+    }
+
+    //---------------------------------
+    static inline bool
+    hasSeparators(const char *text) {
+        return text[4] == '-' && text[7] == '-' && (text[10] == 'T' || text[10] == 't' || text[10] == ' ') && text[13] == ':' && text[16] == ':';
+    }
+
+    // Days from 1970-01-01 (H. Hinnant's days_from_civil)
+    //---------------------------------
+    static constexpr int64_t
+    daysFromCivil(int64_t year, unsigned month, unsigned day) {
+        year -= month <= 2;
+        const int64_t  era = (year >= 0 ? year : year - 399) / 400;
+        const unsigned yoe = unsigned(year - era * 400);
+        const unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + int64_t(doe) - 719468;
+    }
+
+    static_assert(daysFromCivil(1970, 1, 1) == 0);
+    static_assert(daysFromCivil(2000, 3, 1) == 11017);
+
+    //---------------------------------
+    static inline unsigned
+    daysInMonth(unsigned year, unsigned month) {
+        static constexpr uint8_t kDays[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+        const bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        return kDays[month - 1] + (month == 2 && leap);
+    }
+
+    //---------------------------------
+    static bool
+    parseDateTimeScalar(const char *text, DateTime &out) {
+        static constexpr uint8_t kDigits[14] = { 0, 1, 2, 3, 5, 6, 8, 9, 11, 12, 14, 15, 17, 18 };
+
+        unsigned digits[14];
+        unsigned invalid = 0;
+        for (int i = 0; i < 14; ++i) {
+            digits[i] = digitOf(text[kDigits[i]]);
+            invalid  |= digits[i] > 9;
+        }
+        if (invalid != 0) {
+            return false;
+        }
+
+        out.year   = digits[0] * 1000 + digits[1] * 100 + digits[2] * 10 + digits[3];
+        out.month  = digits[4] * 10 + digits[5];
+        out.day    = digits[6] * 10 + digits[7];
+        out.hour   = digits[8] * 10 + digits[9];
+        out.minute = digits[10] * 10 + digits[11];
+        out.second = digits[12] * 10 + digits[13];
+        return true;
+    }
+
+#if defined(kStructuralX86)
+    // The 14 digits are gathered into one vector, checked for 0-9 with a
+    // single compare and folded into two-digit values with one maddubs
+    //---------------------------------
+    kTargetSSE42 static bool
+    parseDateTimeSSE42(const char *text, DateTime &out) {
+        const __m128i head   = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text));       // Bytes 0 to 15
+        const __m128i tail   = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + 3));   // Bytes 3 to 18
+        const __m128i digits = _mm_or_si128(
+            _mm_shuffle_epi8(head, _mm_setr_epi8(0, 1, 2, 3, 5, 6, 8, 9, 11, 12, 14, 15, -1, -1, -1, -1)),
+            _mm_shuffle_epi8(tail, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 14, 15, -1, -1)));
+
+        // The last two lanes are zero, and stay so
+        const __m128i values = _mm_sub_epi8(digits, _mm_setr_epi8('0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0', 0, 0));
+        const __m128i nine   = _mm_set1_epi8(9);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(values, nine), nine)) != 0xFFFF) {
+            return false;
+        }
+
+        const __m128i pairs = _mm_maddubs_epi16(values, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1));
+        out.year   = unsigned(_mm_extract_epi16(pairs, 0)) * 100 + unsigned(_mm_extract_epi16(pairs, 1));
+        out.month  = unsigned(_mm_extract_epi16(pairs, 2));
+        out.day    = unsigned(_mm_extract_epi16(pairs, 3));
+        out.hour   = unsigned(_mm_extract_epi16(pairs, 4));
+        out.minute = unsigned(_mm_extract_epi16(pairs, 5));
+        out.second = unsigned(_mm_extract_epi16(pairs, 6));
+        return true;
+    }
+#endif
+
+    // Up to nine digits as nanoseconds, the rest ignored
+    //---------------------------------
+    static const char *
+    parseFraction(const char *p, const char *end, int64_t &nanos) {
+        const char *digits = p;
+        int64_t     value  = 0;
+        while (p < end && p - digits < 9 && digitOf(*p) < 10) {
+            value = value * 10 + digitOf(*p++);
+        }
+        nanos = value * kPow10[9 - (p - digits)];
+        while (p < end && digitOf(*p) < 10) {
+            ++p;
+        }
+        return p == digits ? nullptr : p;
+    }
+
+    //---------------------------------
+    bool
+    Timestamp::parseIso8601(std::string_view text, Timestamp &out) {
+        return parseIso8601(text, out, StructuralIndex::detect());
+    }
+
+    //---------------------------------
+    bool
+    Timestamp::parseIso8601(std::string_view text, Timestamp &out, Isa isa) {
+        if (text.size() < kDateTimeBytes || hasSeparators(text.data()) == false) {
+            return false;
+        }
+
+        DateTime dt;
+#if defined(kStructuralX86)
+        const bool ok = isa != Isa::Scalar ? parseDateTimeSSE42(text.data(), dt) : parseDateTimeScalar(text.data(), dt);
+#else
+        (void) isa;
+        const bool ok = parseDateTimeScalar(text.data(), dt);
+#endif
+        if (ok == false || dt.month - 1 > 11 || dt.day - 1 >= daysInMonth(dt.year, dt.month) ||
+            dt.hour > 23 || dt.minute > 59 || dt.second > 59) {
+            return false;
+        }
+
+        const char *p   = text.data() + kDateTimeBytes;
+        const char *end = text.data() + text.size();
+
+        int64_t nanos = 0;
+        if (p < end && (*p == '.' || *p == ',')) {
+            p = parseFraction(p + 1, end, nanos);
+            if (p == nullptr) {
+                return false;
+            }
+        }
+
+        // Offset from UTC: local time minus it is UTC
+        int64_t offset = 0;
+        if (p < end && (*p == 'Z' || *p == 'z')) {
+            ++p;
+        }
+        else if (p < end && (*p == '+' || *p == '-')) {
+            const int sign = *p++ == '-' ? -1 : 1;
+            if (end - p < 2 || digitOf(p[0]) > 9 || digitOf(p[1]) > 9) {
+                return false;
+            }
+            const unsigned hours = digitOf(p[0]) * 10 + digitOf(p[1]);
+            unsigned minutes = 0;
+            p += 2;
+            p += p < end && *p == ':';
+            if (p < end) {
+                if (end - p < 2 || digitOf(p[0]) > 9 || digitOf(p[1]) > 9) {
+                    return false;
+                }
+                minutes = digitOf(p[0]) * 10 + digitOf(p[1]);
+                p += 2;
+            }
+            if (hours > 23 || minutes > 59) {
+                return false;
+            }
+            offset = sign * int64_t(hours * 3600 + minutes * 60);
+        }
+        if (p != end) {
+            return false;
+        }
+
+        const int64_t seconds = daysFromCivil(dt.year, dt.month, dt.day) * kSecondsPerDay + dt.hour * 3600 + dt.minute * 60 + dt.second - offset;
+        if (seconds >= kMaxSeconds || seconds <= -kMaxSeconds) {
+            return false;
+        }
+        out.ns = seconds * kNanosPerSecond + nanos;
+        return true;
+    }
+
+    //---------------------------------
+    bool
+    Timestamp::parseEpoch(std::string_view text, Timestamp &out) {
+        const char *p        = text.data();
+        const char *end      = p + text.size();
+        const bool  negative = p < end && *p == '-';
+        p += negative;
+
+        const char *digits  = p;
+        int64_t     seconds = 0;
+        while (p < end && p - digits < 11 && digitOf(*p) < 10) {
+            seconds = seconds * 10 + digitOf(*p++);
+        }
+        if (p == digits || seconds >= kMaxSeconds) {
+            return false;
+        }
+
+        int64_t nanos = 0;
+        if (p < end && *p == '.') {
+            p = parseFraction(p + 1, end, nanos);
+            if (p == nullptr) {
+                return false;
+            }
+        }
+        if (p != end) {
+            return false;
+        }
+
+        const int64_t value = seconds * kNanosPerSecond + nanos;
+        out.ns = negative ? -value : value;
+        return true;
+    }
+
+} // end of namespace
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "structuralIndex.h"
+//--
+#include <cstdint>
+#include <string_view>
+
+//-------------------------------------
+namespace Molly {
+
+    // Nanoseconds since the Unix epoch, UTC. Parsed from both forms the
+    // stream uses: ISO-8601 text ("2024-05-01T12:30:00Z") and epoch
+    // seconds (1714566600.123). The fixed "YYYY-MM-DDTHH:MM:SS" head is
+    // validated and converted with SIMD, in one go.
+    //---------------------------------
+    struct Timestamp {
+        using Isa = StructuralIndex::Isa;
+
+        static constexpr int64_t kNanosPerSecond = 1000000000;
+
+        int64_t ns {};
+
+        double          toSeconds() const       { return double(ns) / double(kNanosPerSecond); }
+
+        // "YYYY-MM-DDTHH:MM:SS", an optional fraction (nanoseconds kept)
+        // and an optional "Z" or "+HH:MM" offset; none means UTC
+        static bool     parseIso8601(std::string_view text, Timestamp &out);
+        static bool     parseIso8601(std::string_view text, Timestamp &out, Isa isa);
+
+        // Seconds, with up to nine decimals kept
+        static bool     parseEpoch(std::string_view text, Timestamp &out);
+
+        constexpr bool  operator==(Timestamp other) const       { return ns == other.ns; }
+        constexpr bool  operator!=(Timestamp other) const       { return ns != other.ns; }
+        constexpr bool  operator<(Timestamp other) const        { return ns <  other.ns; }
+        constexpr bool  operator<=(Timestamp other) const       { return ns <= other.ns; }
+        constexpr bool  operator>(Timestamp other) const        { return ns >  other.ns; }
+        constexpr bool  operator>=(Timestamp other) const       { return ns >= other.ns; }
+    };
+
+} // end of namespace
@@ -0,0 +1,247 @@
+#include "utf8Validator.h"
+#include "simdTarget.h"
+//--
+#include <cstdint>
+#include <cstring>
+
+//-------------------------------------
+namespace Molly {
+
+    //---------------------------------
+    static bool
+    validateScalar(const uint8_t *text, std::size_t size) {
+        std::size_t i = 0;
+        while (i < size) {
+            // ASCII runs, eight bytes at a time
+            if (i + 8 <= size) {
+                uint64_t word;
+                std::memcpy(&word, text + i, sizeof(word));
+                if ((word & 0x8080808080808080ull) == 0) {
+                    i += 8;
+                    continue;
+                }
+            }
+
+            const uint8_t lead = text[i];
+            if (lead < 0x80) {
+                ++i;
+                continue;
+            }
+
+            std::size_t length;
+            uint32_t    code;
+            if (lead >= 0xC2 && lead <= 0xDF) {
+                length = 2;
+                code   = lead & 0x1F;
+            }
+            else if ((lead & 0xF0) == 0xE0) {
+                length = 3;
+                code   = lead & 0x0F;
+            }
+            else if (lead >= 0xF0 && lead <= 0xF4) {
+                length = 4;
+                code   = lead & 0x07;
+            }
+            else {
+                return false;
+            }
+            if (i + length > size) {
+                return false;
+            }
+
+            for (std::size_t k = 1; k < length; ++k) {
+                if ((text[i + k] & 0xC0) != 0x80) {
+                    return false;
+                }
+                code = (code << 6) | (text[i + k] & 0x3F);
+            }
+            if ((length == 3 && (code < 0x800 || (code >= 0xD800 && code <= 0xDFFF))) ||
+                (length == 4 && (code < 0x10000 || code > 0x10FFFF))) {
+                return false;
+            }
+            i += length;
+        }
+        return true;
+    }
+
+#if defined(kStructuralX86)
+    // Error bits set by the lookups; a byte is valid if they all cancel
+    enum : uint8_t {
+        kTooShort     = 1 << 0,     // Lead not followed by a continuation
+        kTooLong      = 1 << 1,     // Continuation after ASCII
+        kOverlong3    = 1 << 2,
+        kTooLarge     = 1 << 3,
+        kSurrogate    = 1 << 4,
+        kOverlong2    = 1 << 5,
+        kTooLarge1000 = 1 << 6,
+        kOverlong4    = 1 << 6,
+        kTwoConts     = 1 << 7,
+        kCarry        = kTooShort | kTooLong | kTwoConts,
+    };
+
+    // By high nibble of the previous byte
+    static constexpr uint8_t kByte1High[16] = {
+        kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+        kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+        kTooShort | kOverlong2,
+        kTooShort,
+        kTooShort | kOverlong3 | kSurrogate,
+        kTooShort | kTooLarge | kTooLarge1000 | kOverlong4,
+    };
+
+    // By low nibble of the previous byte
+    static constexpr uint8_t kByte1Low[16] = {
+        kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+        kCarry | kOverlong2,
+        kCarry,
+        kCarry,
+        kCarry | kTooLarge,
+        kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+        kCarry | kTooLarge | kTooLarge1000, kCarry | kTooLarge | kTooLarge1000,
+    };
+
+    // By high nibble of the current byte
+    static constexpr uint8_t kByte2High[16] = {
+        kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4,
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+        kTooShort, kTooShort, kTooShort, kTooShort,
+    };
+
+    //---------------------------------
+    kTargetSSE42 static bool
+    validateSSE42(const uint8_t *text, std::size_t size) {
+        const __m128i byte1High = _mm_loadu_si128(reinterpret_cast<const __m128i *>(kByte1High));
+        const __m128i byte1Low  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(kByte1Low));
+        const __m128i byte2High = _mm_loadu_si128(reinterpret_cast<const __m128i *>(kByte2High));
+        const __m128i nibble    = _mm_set1_epi8(0x0F);
+        // Leads too close to the end for their continuations
+        const __m128i lastLeads = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, char(0xF0 - 1), char(0xE0 - 1), char(0xC0 - 1));
+
+        __m128i error      = _mm_setzero_si128();
+        __m128i previous   = _mm_setzero_si128();
+        __m128i incomplete = _mm_setzero_si128();
+        for (std::size_t i = 0; i < size; i += 16) {
+            __m128i input;
+            if (i + 16 <= size) {
+                input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+            }
+            else {
+                uint8_t tail[16] = {};
+                std::memcpy(tail, text + i, size - i);
+                input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tail));
+            }
+
+            if (_mm_movemask_epi8(input) == 0) {
+                error = _mm_or_si128(error, incomplete);
+            }
+            else {
+                const __m128i prev1   = _mm_alignr_epi8(input, previous, 15);
+                const __m128i special = _mm_and_si128(_mm_and_si128(
+                    _mm_shuffle_epi8(byte1High, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+                    _mm_shuffle_epi8(byte1Low, _mm_and_si128(prev1, nibble))),
+                    _mm_shuffle_epi8(byte2High, _mm_and_si128(_mm_srli_epi16(input, 4), nibble)));
+
+                // Third and fourth bytes of a sequence must be continuations too
+                const __m128i third  = _mm_subs_epu8(_mm_alignr_epi8(input, previous, 14), _mm_set1_epi8(char(0xE0 - 0x80)));
+                const __m128i fourth = _mm_subs_epu8(_mm_alignr_epi8(input, previous, 13), _mm_set1_epi8(char(0xF0 - 0x80)));
+                const __m128i must23 = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8(char(0x80)));
+
+                error      = _mm_or_si128(error, _mm_xor_si128(must23, special));
+                incomplete = _mm_subs_epu8(input, lastLeads);
+            }
+            previous = input;
+        }
+        error = _mm_or_si128(error, incomplete);
+        return _mm_testz_si128(error, error) != 0;
+    }
+
+    //---------------------------------
+    kTargetAVX2 static inline __m256i
+    previousBytes(__m256i input, __m256i previous, int n) {
+        const __m256i joined = _mm256_permute2x128_si256(previous, input, 0x21);
+        switch (n) {
+            case 1:     return _mm256_alignr_epi8(input, joined, 15);
+            case 2:     return _mm256_alignr_epi8(input, joined, 14);
+            default:    return _mm256_alignr_epi8(input, joined, 13);
+        }
+    }
+
+    //---------------------------------
+    kTargetAVX2 static bool
+    validateAVX2(const uint8_t *text, std::size_t size) {
+        const __m256i byte1High = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(kByte1High)));
+        const __m256i byte1Low  = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(kByte1Low)));
+        const __m256i byte2High = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(kByte2High)));
+        const __m256i nibble    = _mm256_set1_epi8(0x0F);
+        const __m256i lastLeads = _mm256_setr_epi8(
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, char(0xF0 - 1), char(0xE0 - 1), char(0xC0 - 1));
+
+        __m256i error      = _mm256_setzero_si256();
+        __m256i previous   = _mm256_setzero_si256();
+        __m256i incomplete = _mm256_setzero_si256();
+        for (std::size_t i = 0; i < size; i += 32) {
+            __m256i input;
+            if (i + 32 <= size) {
+                input = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i));
+            }
+            else {
+                uint8_t tail[32] = {};
+                std::memcpy(tail, text + i, size - i);
+                input = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(tail));
+            }
+
+            if (_mm256_movemask_epi8(input) == 0) {
+                error = _mm256_or_si256(error, incomplete);
+            }
+            else {
+                const __m256i prev1   = previousBytes(input, previous, 1);
+                const __m256i special = _mm256_and_si256(_mm256_and_si256(
+                    _mm256_shuffle_epi8(byte1High, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+                    _mm256_shuffle_epi8(byte1Low, _mm256_and_si256(prev1, nibble))),
+                    _mm256_shuffle_epi8(byte2High, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble)));
+
+                const __m256i third  = _mm256_subs_epu8(previousBytes(input, previous, 2), _mm256_set1_epi8(char(0xE0 - 0x80)));
+                const __m256i fourth = _mm256_subs_epu8(previousBytes(input, previous, 3), _mm256_set1_epi8(char(0xF0 - 0x80)));
+                const __m256i must23 = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(char(0x80)));
+
+                error      = _mm256_or_si256(error, _mm256_xor_si256(must23, special));
+                incomplete = _mm256_subs_epu8(input, lastLeads);
+            }
+            previous = input;
+        }
+        error = _mm256_or_si256(error, incomplete);
+        return _mm256_testz_si256(error, error) != 0;
+    }
+#endif
+
+    //---------------------------------
+    bool
+    Utf8Validator::validate(std::string_view text) {
+        return validate(text, StructuralIndex::detect());
+    }
+
+    //---------------------------------
+    bool
+    Utf8Validator::validate(std::string_view text, Isa isa) {
+        const auto *bytes = reinterpret_cast<const uint8_t *>(text.data());
+#if defined(kStructuralX86)
+        if (isa == Isa::AVX2) {
+            return validateAVX2(bytes, text.size());
+        }
+        if (isa == Isa::SSE42) {
+            return validateSSE42(bytes, text.size());
+        }
+#else
+        (void) isa;
+#endif
+        return validateScalar(bytes, text.size());
+    }
+
+} // end of namespace
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "structuralIndex.h"
+//--
+#include <string_view>
+
+//-------------------------------------
+namespace Molly {
+
+    // UTF-8 check of a whole frame, 32 or 16 bytes per step with the
+    // lookup algorithm of Keiser and Lemire: ASCII blocks cost a single
+    // movemask, others three nibble lookups and a few shifts. Overlong
+    // forms, surrogates and code points past U+10FFFF are errors, as in
+    // RFC 3629. Scalar fallback.
+    //---------------------------------
+    class Utf8Validator {
+        public:
+            using Isa = StructuralIndex::Isa;
+
+        public:
+            static bool validate(std::string_view text);
+            static bool validate(std::string_view text, Isa isa);
+    };
+
+} // end of namespace
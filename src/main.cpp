@@ -5,76 +5,37 @@
 #include "root_certificates.hpp"
 #include "log/loggerColorConsole.h"
 #include "session.h"
+#include "net/orderClient.h"
+#include "net/snapshotBootstrap.h"
+#include "feed/incrementalScanner.h"
+#include "feed/syncDetector.h"
+#include "molly/messageDecoder.h"
+#include "molly/messageStore.h"
+#include "molly/parallelDecoder.h"
+#include "utils/stringInterner.h"
 
-#include <nlohmann/json.hpp>
-using json = nlohmann::json;
-
-#include <unordered_set>
+#include <cstdlib>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
 
 //-------------------------------------
 using namespace MindShake;
 
+// One --order
 //-------------------------------------
-static bool
-getValue(const json &j, std::string &value, const std::string &key = "none") {
-    try {
-        value = j.get<std::string>();
-        return true;
-    }
-    catch (const json::type_error &e) {
-        Logger::exception("Type error parsing key '{}': {}", key, e.what());
-    }
-    catch (const json::out_of_range &e) {
-        Logger::exception("Out of range error parsing key '{}': {}", key, e.what());
-    }
-    catch (const json::exception &e) {
-        Logger::exception("Exception error parsing key '{}': {}", key, e.what());
-    }
-    catch (const std::exception &e) {
-        Logger::exception("Exception error parsing key '{}': {}", key, e.what());
-    }
-    catch (...) {
-        Logger::exception("Unknown exception occurred parsing key '{}'", key);
-    }
-
-    return false;
-}
+struct OrderRequest {
+    std::string betslipId;
+    double      price {};
+    double      stake {};
+};
 
 //-------------------------------------
-static void
-iterateJSON(const json &j, bool &syncFound, std::string &token, std::unordered_set<std::string> &competitions) {
-    if (j.is_object()) {
-        std::string key, value;
-        for (auto it = j.begin(); it != j.end(); ++it) {
-            if (it.value().is_object() || it.value().is_array()) {
-                iterateJSON(it.value(), syncFound, token, competitions);
-                continue;
-            }
-
-            key = it.key();
-            if (key == "competition_name") {
-                if (getValue(it.value(), value, key)) {
-                    competitions.emplace(value);
-                }
-            }
-            else if (syncFound && key == "token") {
-                if (getValue(it.value(), value, key)) {
-                    token = value;
-                }
-            }
-        }
-    }
-    else if (j.is_array()) {
-        for (const auto &item : j) {
-            iterateJSON(item, syncFound, token, competitions);
-        }
-    }
-    else if (j.is_string()) {
-        auto name = j.get<std::string>();
-        if (name == "sync") {
-            syncFound = true;
-        }
-    }
+static bool
+parseAmount(const char *text, double &value) {
+    char *end = nullptr;
+    value = std::strtod(text, &end);
+    return end != text && *end == '\0' && value > 0.0;
 }
 
 //-------------------------------------
@@ -84,9 +45,93 @@ main(int argc, char** argv) {
     Logger::setLevel(LogLevel::Info);
 
     // Check command line arguments.
-    if(argc != 3) {
+    bool useKernelTLS {};
+    bool showStats {};
+    std::vector<std::string> snapshotTargets;
+    std::string resumeToken;
+    std::string capturePath;
+    bool parallelBurst {};
+    bool incremental {};
+    bool validate {};
+    std::vector<Molly::Sport> onlySports;
+    int pingSeconds {};
+    std::vector<OrderRequest> orders;
+    for (int i = 3; i < argc; ++i) {
+        std::string_view option = argv[i];
+        if (option == "--ktls") {
+            useKernelTLS = true;
+        }
+        else if (option == "--stats") {
+            showStats = true;
+        }
+        else if (option == "--snapshot" && i + 1 < argc) {
+            snapshotTargets.emplace_back(argv[++i]);
+        }
+        else if (option == "--resume" && i + 1 < argc) {
+            resumeToken = argv[++i];
+        }
+        else if (option == "--capture" && i + 1 < argc) {
+            capturePath = argv[++i];
+        }
+        else if (option == "--parallel") {
+            parallelBurst = true;
+        }
+        else if (option == "--incremental") {
+            incremental = true;
+        }
+        else if (option == "--validate") {
+            validate = true;
+        }
+        else if (option == "--sport" && i + 1 < argc && Molly::findCode<Molly::Sport>(argv[i + 1]) != Molly::Sport::Count) {
+            onlySports.emplace_back(Molly::findCode<Molly::Sport>(argv[++i]));
+        }
+        else if (option == "--ping" && i + 1 < argc && std::atoi(argv[i + 1]) > 0) {
+            pingSeconds = std::atoi(argv[++i]);
+        }
+        else if (option == "--order" && i + 3 < argc) {
+            OrderRequest order { argv[i + 1] };
+            if (parseAmount(argv[i + 2], order.price) == false || parseAmount(argv[i + 3], order.stake) == false) {
+                argc = 0;
+                break;
+            }
+            orders.emplace_back(std::move(order));
+            i += 3;
+        }
+        else {
+            argc = 0;
+            break;
+        }
+    }
+
+    // Snapshot reconciliation and the worker pool need whole frames
+    if (incremental && (snapshotTargets.empty() == false || parallelBurst)) {
+        argc = 0;
+    }
+
+    if(argc < 3) {
         Logger::error(R"(
-Usage: {0} <host> <port> <text>"
+Usage: {0} <host> <port> [options]
+Options:
+    --ktls              Let the kernel decrypt the stream (Linux, OpenSSL 3)
+    --stats             Print the CPU cost of reading the stream
+    --snapshot <path>   Fetch initial state from this REST path in parallel
+                        with the stream, shaped like a stream frame
+                        (repeatable)
+    --resume <token>    Attach the stream from a previous sync token
+    --capture <file>    Save the stream frames, one per line (bench input)
+    --parallel          Decode the pre-sync burst on all cores
+    --incremental       Decode messages as their bytes arrive, without
+                        waiting for the whole frame (not with --snapshot
+                        or --parallel)
+    --validate          Check stream frames are UTF-8 again in the
+                        decoder, on top of Beast's check
+    --sport <code>      Decode only the events of this sport, e.g. fb
+                        (repeatable)
+    --ping <seconds>    Send a keep-alive ping this often while the
+                        stream is open
+    --order <betslip> <price> <stake>
+                        Place an order once logged in, next to the
+                        stream (repeatable)
 Example:
     {0} api.mollybet.com 443
         )", argv[0]);
@@ -108,16 +153,286 @@ Example:
 
     bool syncFound {};
     std::string token;
-    std::unordered_set<std::string> competitions;
+    StringInterner competitions;
+
+    // Known sports index the array by enum, others come after them
+    Molly::CodeIds<Molly::Sport> sports;
+    std::vector<uint64_t> eventsPerSport(sports.size());
+
+    // Competition names only come with events; offers are skipped undecoded,
+    // and so are events of other sports when some were asked for
+    Molly::MessageFilter filter;
+    filter.addType(Molly::MessageType::Event).addType(Molly::MessageType::Sync);
+    for (auto sport : onlySports) {
+        filter.addSport(sport);
+    }
+
+    // Beast already rejects text frames that are not UTF-8
+    Molly::MessageDecoder decoder;
+    decoder.setFilter(filter);
+    decoder.setTrusted(validate == false);
+
+    // Events are merged into the store, updates touching only their fields;
+    // applied tells the handlers below which changed, and whether the event
+    // is new. Partial updates of events the filter dropped are ignored.
+    Molly::MessageStore store;
+    store.setFilter(filter);
+    decoder.setKnownEvents([&store](std::string_view eventId) {
+        return store.findEvent(eventId) != nullptr;
+    });
+    Molly::Applied applied;
+
+    const auto collect = Molly::Overloaded {
+        [&](const Molly::Event &event) {
+            if (applied.stored == false) {
+                return;
+            }
+
+            // Known names are found without allocating
+            if (applied.changed & Molly::Event::kCompetitionName) {
+                competitions.intern(event.competitionName);
+            }
+
+            // Once per event, with the sport it was stored with
+            if (applied.created) {
+                const uint32_t sport = sports.get(store.findEvent(event.eventId)->sport);
+                if (sport >= eventsPerSport.size()) {
+                    eventsPerSport.resize(sport + 1);
+                }
+                ++eventsPerSport[sport];
+            }
+        },
+        [&](const Molly::Sync &sync) {
+            syncFound = true;
+            token     = sync.token;
+        },
+        [](const auto &) {
+        },
+    };
+    const Molly::MessageDecoder::Handler onMessage = [&](const Molly::Message &message, Molly::FieldMask fields) {
+        applied = store.apply(message, fields);
+        std::visit(collect, message);
+    };
+    Molly::SyncDetector syncDetector;
+
+    // Worker threads for the REST snapshot and the pre-sync burst
+    std::unique_ptr<WorkerPool> workers;
+    if (snapshotTargets.empty() == false || parallelBurst) {
+        workers = std::make_unique<WorkerPool>();
+    }
+
+    // Frames are decoded on the workers and merged back in arrival order
+    std::unique_ptr<Molly::ParallelDecoder> parallel;
+    if (parallelBurst) {
+        parallel = std::make_unique<Molly::ParallelDecoder>(*workers);
+        parallel->setFilter(filter);
+        parallel->setTrusted(validate == false);
+        parallel->setInvalidHandler([](const char *error) {
+            Logger::error("Invalid frame: {}", error);
+        });
+    }
+
+    auto decodeFrame = [&](std::string_view frame, const Molly::MessageDecoder::Handler &handler) {
+        if (parallel) {
+            parallel->decode(frame, handler);
+        }
+        else if (decoder.decode(frame, handler) == false) {
+            Logger::error("Invalid frame: {}", decoder.getLastError());
+        }
+    };
+    auto flushFrames = [&](const Molly::MessageDecoder::Handler &handler) {
+        if (parallel) {
+            parallel->flush(handler);
+        }
+    };
+    // Of the frame whose messages are being handled
+    auto frameTs = [&]() {
+        return parallel ? parallel->getFrameTs() : decoder.getFrameTs();
+    };
+
+    std::ofstream capture;
+    if (capturePath.empty() == false) {
+        capture.open(capturePath, std::ios::binary);
+        if (capture.is_open() == false) {
+            Logger::error("Cannot create '{}'", capturePath);
+            return EXIT_FAILURE;
+        }
+    }
 
     // Launch the asynchronous operation
-    auto session = std::make_shared<Session>(ioc, ctx);
+    auto https   = std::make_shared<HttpsClient>(ioc, ctx);
+    auto session = std::make_shared<Session>(ioc, ctx, https);
     session->setCredentials("devinterview", "OwAb6wrocirEv");
+    session->setKernelTLS(useKernelTLS);
+    session->setResumeToken(resumeToken);
+    session->setPingInterval(std::chrono::seconds(pingSeconds));
+
+    // Optional REST snapshot, decoded on the workers into the same store.
+    // Its parts do not come through Beast: they are checked to be UTF-8.
+    std::shared_ptr<SnapshotBootstrap> bootstrap;
+    std::unique_ptr<Molly::ParallelDecoder> snapshotDecoder;
+    if (snapshotTargets.empty() == false) {
+        bootstrap = std::make_shared<SnapshotBootstrap>(ioc, https, host, port);
+        for (auto &target : snapshotTargets) {
+            bootstrap->addTarget(std::move(target));
+        }
+        snapshotDecoder = std::make_unique<Molly::ParallelDecoder>(*workers);
+        snapshotDecoder->setFilter(filter);
+        snapshotDecoder->setInvalidHandler([](const char *error) {
+            Logger::error("Invalid snapshot part: {}", error);
+        });
+    }
+
+    // "ts" of the snapshot part each stored event came with (stored
+    // events never move). Its sync record gives the resume token.
+    std::unordered_map<const Molly::Event *, double> snapshotTs;
+    const Molly::MessageDecoder::Handler onSnapshotMessage = [&](const Molly::Message &message, Molly::FieldMask fields) {
+        onMessage(message, fields);
+        const auto *event = std::get_if<Molly::Event>(&message);
+        if (event != nullptr && applied.stored) {
+            snapshotTs[store.findEvent(event->eventId)] = snapshotDecoder->getFrameTs();
+        }
+    };
+
+    // Records of the frames held meanwhile are checked one by one against
+    // what the snapshot stored: offers by their own "ts", events by their
+    // frame's against their part's. Those not newer would take it back.
+    std::size_t covered {};
+    const Molly::MessageDecoder::Handler onReplayedMessage = [&](const Molly::Message &message, Molly::FieldMask fields) {
+        if (const auto *event = std::get_if<Molly::Event>(&message)) {
+            const auto it = snapshotTs.find(store.findEvent(event->eventId));
+            if (it != snapshotTs.end() && frameTs() != 0 && frameTs() <= it->second) {
+                ++covered;
+                return;
+            }
+        }
+        else if (const auto *offer = std::get_if<Molly::Offer>(&message)) {
+            const auto *stored = store.findOffer(offer->eventId, offer->betType, offer->bookie.text);
+            if (stored != nullptr && (fields & Molly::Offer::kTs) && offer->ts <= stored->ts) {
+                ++covered;
+                return;
+            }
+        }
+        onMessage(message, fields);
+    };
+
+    // Optional orders, on the connections the login warmed up
+    std::shared_ptr<OrderClient> orderClient;
+    if (orders.empty() == false) {
+        orderClient = std::make_shared<OrderClient>(https, host, port);
+    }
+
+    // Pooled connections keep a read armed to notice idle closes, so
+    // ioc.run() only returns once the client is stopped. Handlers all
+    // run on this thread.
+    std::size_t httpsUsers = orderClient ? 2 : 1;
+    auto releaseHttps = [&]() {
+        if (--httpsUsers == 0) {
+            https->stop();
+        }
+    };
+    session->setDoneHandler(releaseHttps);
+
+    std::size_t answered {};
+    auto placeOrders = [&](const std::string &sessionToken) {
+        const OrderTemplate::Headers headers = { { "Session", sessionToken } };
+        orderClient->start(1, [&, headers](bool ready) {
+            if (ready == false) {
+                Logger::error("Orders: cannot connect to '{}'", host);
+                return releaseHttps();
+            }
+
+            for (const auto &order : orders) {
+                const std::string body = R"({"betslip_id": ")" + order.betslipId + R"(", "price": {price}, "stake": ["EUR", {stake}]})";
+                auto orderTemplate = std::make_shared<const OrderTemplate>(host, "/v1/orders/", body, headers);
+                orderClient->place(orderTemplate, order.price, order.stake, [&, betslipId = order.betslipId](const OrderResult &result) {
+                    if (result.ec) {
+                        Logger::error("Order {}: {}", betslipId, result.ec.message());
+                    }
+                    else {
+                        Logger::info("Order {}: HTTP {} in {:.1f} us", betslipId, result.status,
+                                     std::chrono::duration<double, std::micro>(result.latency).count());
+                    }
+                    if (++answered == orders.size()) {
+                        releaseHttps();
+                    }
+                });
+            }
+        });
+    };
+
+    if (bootstrap || orderClient) {
+        session->setLoginHandler([&](const std::string &sessionToken) {
+            if (orderClient) {
+                placeOrders(sessionToken);
+            }
+            if (bootstrap == nullptr) {
+                return;
+            }
+
+            bootstrap->run(sessionToken,
+                [&](const std::string &, std::string_view body) {
+                    snapshotDecoder->decode(body, onSnapshotMessage);
+                },
+                // Held records are checked against the whole snapshot
+                [&](std::string_view frame) {
+                    snapshotDecoder->flush(onSnapshotMessage);
+                    decodeFrame(frame, onReplayedMessage);
+                },
+                [&](bool ok) {
+                    if (ok == false) {
+                        Logger::warning("Snapshot incomplete, relying on the stream");
+                    }
+                    snapshotDecoder->flush(onSnapshotMessage);
+                    flushFrames(onReplayedMessage);
+                    if (syncFound) {
+                        session->close();
+                    }
+                });
+        });
+    }
+
+    // Messages are decoded as soon as their closing bracket is received
+    Molly::IncrementalScanner scanner;
+    if (incremental) {
+        session->setFragmentParser([&](const std::string_view &fragment, bool last) {
+            if (capture.is_open()) {
+                capture << fragment;
+                if (last) {
+                    capture << '\n';
+                }
+            }
+
+            scanner.feed(fragment, [&](std::string_view element) {
+                if (decoder.decodeMessage(element, onMessage) == false) {
+                    Logger::error("Invalid message: {}", decoder.getLastError());
+                }
+            });
+            if (last && scanner.finish() == false) {
+                Logger::error("Invalid frame");
+            }
+            // No need to wait for the rest of the frame
+            return syncFound;
+        });
+    }
+
     bool result = session->run(host, port, [&](const std::string_view &received) {
-        json data = json::parse(received);
+        if (capture.is_open()) {
+            capture << received << '\n';
+        }
+
+        // Held frames are replayed once the snapshot is in
+        if (bootstrap && bootstrap->admitStreamFrame(received) == false) {
+            return false;
+        }
 
-        iterateJSON(data, syncFound, token, competitions);
-        return syncFound;
+        // Spotted without parsing: the session stops reading after this frame
+        const bool sync = syncDetector.find(received) != Molly::SyncDetector::kNotFound;
+        decodeFrame(received, onMessage);
+        if (sync) {
+            flushFrames(onMessage);
+        }
+        return sync;
     });
     if (result == false) {
         return EXIT_FAILURE;
@@ -134,11 +449,109 @@ Example:
     catch (...) {
         Logger::exception("Exception: IOC");
     }
+    // The stream may have ended before sync
+    flushFrames(onMessage);
+
+    if (showStats) {
+        const auto &stats = session->getFeedStats();
+        Logger::info("Feed: {:.2f} MB in {} frames, CPU {:.1f} ms ({:.2f} ms/MB), kTLS rx: {}",
+                     stats.megabytes(), stats.frames, stats.cpuSeconds * 1000.0, stats.cpuMsPerMB(),
+                     stats.kernelTLSRecv ? "on" : "off");
+
+        auto decoded = decoder.getStats();
+        if (parallel) {
+            decoded += parallel->getStats();
+        }
+        if (snapshotDecoder) {
+            decoded += snapshotDecoder->getStats();
+        }
+        for (std::size_t type = 0; type < decoded.decoded.size(); ++type) {
+            if (decoded.decoded[type] != 0) {
+                Logger::info("Decoder: {} {} messages", decoded.decoded[type], Molly::MessageDecoder::getName(Molly::MessageType(type)));
+            }
+        }
+        Logger::info("Decoder: {} skipped, {} of unknown type", decoded.skipped, decoded.unknown);
+        if (decoded.shapeHits + decoded.shapeMisses != 0) {
+            Logger::info("Decoder: {:.1f}% of records in a learned key order", 100.0 * decoded.shapeHits / (decoded.shapeHits + decoded.shapeMisses));
+        }
+        auto filtered = decoder.getFilterStats();
+        if (parallel) {
+            filtered += parallel->getFilterStats();
+        }
+        if (snapshotDecoder) {
+            filtered += snapshotDecoder->getFilterStats();
+        }
+        if (onlySports.empty() == false) {
+            Logger::info("Filter: {} events of the chosen sports, {} of others skipped undecoded", filtered.sports.hits, filtered.sports.skips);
+        }
+        std::string perSport;
+        for (uint32_t sport = 0; sport < eventsPerSport.size(); ++sport) {
+            if (eventsPerSport[sport] != 0) {
+                perSport += fmt::format(" {}: {}", sports.getText(sport), eventsPerSport[sport]);
+            }
+        }
+        if (perSport.empty() == false) {
+            Logger::info("Store: events per sport:{}", perSport);
+        }
+        auto markets = decoder.getMarketStats();
+        if (parallel) {
+            markets += parallel->getMarketStats();
+        }
+        if (snapshotDecoder) {
+            markets += snapshotDecoder->getMarketStats();
+        }
+        if (markets.hits + markets.misses != 0) {
+            Logger::info("Markets: {} bet_types cached, {} parsed, {} not understood", markets.hits, markets.misses, markets.unknown);
+        }
+        const auto &stored = store.getStats();
+        if (stored.created + stored.updates != 0) {
+            Logger::info("Store: {} events, {} updates merged, {} fields changed, {} updates of unknown events ignored",
+                         store.getEvents(), stored.updates, stored.changed, stored.ignored);
+        }
+        const auto &sync = syncDetector.getStats();
+        if (sync.frames != 0) {
+            Logger::info("Sync: {} frames scanned, {} with the bytes, {} confirmed", sync.frames, sync.candidates, sync.found);
+        }
+        if (incremental) {
+            Logger::info("Incremental: {} messages, {:.1f} KB copied across fragments", scanner.getElements(), scanner.getCopiedBytes() / 1024.0);
+        }
+        if (decoded.badFrames + decoded.malformed != 0) {
+            Logger::warning("Decoder: {} bad frames, {} malformed records ({} not UTF-8)", decoded.badFrames, decoded.malformed, decoded.badUtf8);
+        }
+        for (std::size_t type = 0; type < decoded.rejected.size(); ++type) {
+            if (decoded.rejected[type] == 0) {
+                continue;
+            }
+            std::string fields;
+            for (std::size_t field = 0; field < decoded.fieldErrors[type].size(); ++field) {
+                if (decoded.fieldErrors[type][field] != 0) {
+                    fields += fmt::format(" {}: {}", Molly::MessageDecoder::getFieldName(Molly::MessageType(type), field), decoded.fieldErrors[type][field]);
+                }
+            }
+            Logger::warning("Decoder: {} {} records rejected, field errors:{}", decoded.rejected[type], Molly::MessageDecoder::getName(Molly::MessageType(type)), fields);
+        }
+
+        if (bootstrap) {
+            Logger::info("Snapshot: {} held stream records already covered", covered);
+        }
+
+        if (orderClient) {
+            const auto &latency = orderClient->getLatencyStats();
+            Logger::info("Orders: {} answered, latency min {:.1f} us, mean {:.1f} us, max {:.1f} us",
+                         latency.count(), latency.minUs(), latency.meanUs(), latency.maxUs());
+        }
+
+        const auto &writes = session->getWriteStats();
+        if (writes.messages != 0) {
+            Logger::info("Writes: {} messages, {} bytes, max queue {}, latency mean {:.1f} us, max {:.1f} us",
+                         writes.messages, writes.bytes, writes.maxQueueDepth, writes.latency.meanUs(), writes.latency.maxUs());
+        }
+    }
 
     if (syncFound) {
         Logger::debug("Sync Found: token = {}", token);
-        for (const auto &c : competitions) {
-            Logger::info("Competition: {}", c);
+        for (StringInterner::Id id = 0; id < competitions.size(); ++id) {
+            Logger::info("Competition: {}", competitions.get(id));
         }
     }
 
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "utils/perfectHash.h"
+#include "utils/stringInterner.h"
+//--
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+// Small fixed vocabularies of the stream, as dense enums. Known codes
+// are found through a perfect hash built at compile time; anything else
+// is Count, and gets a runtime id from CodeIds.
+//-------------------------------------
+namespace Molly {
+
+    //---------------------------------
+    enum class Sport : uint8_t {
+        Football,
+        FootballHalfTime,
+        FootballCorners,
+        Basketball,
+        Tennis,
+        AmericanFootball,
+        IceHockey,
+        Baseball,
+        Count,
+    };
+
+    //---------------------------------
+    enum class Bookie : uint8_t {
+        Pinnacle,
+        Sbobet,
+        Ibc,
+        Isn,
+        Betfair,
+        Betdaq,
+        Matchbook,
+        Singbet,
+        Count,
+    };
+
+    // Same order as the enums
+    //---------------------------------
+    template <typename Enum>
+    struct CodeTable;
+
+    template <>
+    struct CodeTable<Sport> {
+        static constexpr std::array<std::string_view, std::size_t(Sport::Count)> kCodes = {
+            "fb", "fb_ht", "fb_corn", "basket", "tennis", "af", "ih", "baseball",
+        };
+    };
+
+    template <>
+    struct CodeTable<Bookie> {
+        static constexpr std::array<std::string_view, std::size_t(Bookie::Count)> kCodes = {
+            "pin", "sbo", "ibc", "isn", "bf", "bdaq", "mbook", "sing",
+        };
+    };
+
+    //---------------------------------
+    template <typename Enum>
+    struct CodeHash {
+        static constexpr auto kHash = MindShake::makePerfectHash(CodeTable<Enum>::kCodes);
+
+        static_assert(kHash.valid, "No perfect hash seed for the codes");
+    };
+
+    // Enum of a code, Count if it is not in the table
+    //---------------------------------
+    template <typename Enum>
+    constexpr Enum
+    findCode(std::string_view code) {
+        return Enum(CodeHash<Enum>::kHash.find(code));
+    }
+
+    //---------------------------------
+    template <typename Enum>
+    constexpr std::string_view
+    getCode(Enum value) {
+        return CodeTable<Enum>::kCodes[std::size_t(value)];
+    }
+
+    // A code field as decoded: its text, and its enum when known
+    //---------------------------------
+    template <typename Enum>
+    struct Code {
+        std::string_view    text;
+        Enum                value { Enum::Count };
+
+        bool    isKnown() const     { return value != Enum::Count; }
+    };
+
+    using SportCode  = Code<Sport>;
+    using BookieCode = Code<Bookie>;
+
+    // Dense ids over a vocabulary: the known codes keep their enum value,
+    // unknown ones are interned after them. Arrays indexed by id replace
+    // maps keyed by name; size() tells how large they must be.
+    // Not thread safe.
+    //---------------------------------
+    template <typename Enum>
+    class CodeIds {
+        public:
+            static constexpr uint32_t kKnown = uint32_t(Enum::Count);
+
+        public:
+            uint32_t    get(const Code<Enum> &code) {
+                return code.isKnown() ? uint32_t(code.value) : kKnown + mOthers.intern(code.text);
+            }
+
+            std::string_view getText(uint32_t id) const {
+                return id < kKnown ? getCode(Enum(id)) : mOthers.get(id - kKnown);
+            }
+
+            std::size_t size() const        { return kKnown + mOthers.size(); }
+
+        protected:
+            MindShake::StringInterner   mOthers { 64 };
+    };
+
+} // end of namespace
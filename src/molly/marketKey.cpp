@@ -0,0 +1,156 @@
+#include "marketKey.h"
+#include "utils/perfectHash.h"
+//--
+#include <cstring>
+
+//-------------------------------------
+namespace Molly {
+
+    // What follows each market code
+    //---------------------------------
+    struct KindSpec {
+        std::string_view    code;
+        MarketKind          kind;
+        uint8_t             teams;
+        bool                line;
+    };
+
+    static constexpr KindSpec kKinds[] = {
+        { "ml",         MarketKind::MoneyLine,      1, false },
+        { "ah",         MarketKind::AsianHandicap,  1, true  },
+        { "to",         MarketKind::TotalOver,      0, true  },
+        { "tu",         MarketKind::TotalUnder,     0, true  },
+        { "ahover",     MarketKind::TotalOver,      0, true  },
+        { "ahunder",    MarketKind::TotalUnder,     0, true  },
+        { "tahover",    MarketKind::TeamTotalOver,  1, true  },
+        { "tahunder",   MarketKind::TeamTotalUnder, 1, true  },
+        { "dc",         MarketKind::DoubleChance,   2, false },
+    };
+
+    // Comma separated tokens
+    //---------------------------------
+    class Tokens {
+        public:
+            explicit    Tokens(std::string_view text) : mText(text) {}
+
+            bool        empty() const       { return mDone; }
+
+            std::string_view next() {
+                const auto comma = mText.find(',');
+                const auto token = mText.substr(0, comma);
+                mDone = comma == std::string_view::npos;
+                mText = mDone ? std::string_view() : mText.substr(comma + 1);
+                return token;
+            }
+
+        protected:
+            std::string_view    mText;
+            bool                mDone {};
+    };
+
+    //---------------------------------
+    static Team
+    teamOf(std::string_view token) {
+        if (token.size() != 1) {
+            return Team::None;
+        }
+        switch (token[0]) {
+            case 'h':   return Team::Home;
+            case 'a':   return Team::Away;
+            case 'd':   return Team::Draw;
+            default:    return Team::None;
+        }
+    }
+
+    //---------------------------------
+    static bool
+    parseLine(std::string_view token, int32_t &line) {
+        const bool negative = token.empty() == false && token[0] == '-';
+        token.remove_prefix(negative || (token.empty() == false && token[0] == '+'));
+        if (token.empty() || token.size() > 9) {
+            return false;
+        }
+
+        int32_t value = 0;
+        for (char c : token) {
+            const unsigned digit = unsigned(uint8_t(c) - uint8_t('0'));
+            if (digit > 9) {
+                return false;
+            }
+            value = value * 10 + int32_t(digit);
+        }
+        line = negative ? -value : value;
+        return true;
+    }
+
+    //---------------------------------
+    MarketKey
+    MarketKey::parse(std::string_view betType) {
+        Tokens tokens(betType);
+
+        const auto sideText = tokens.next();
+        if ((sideText != "for" && sideText != "against") || tokens.empty()) {
+            return {};
+        }
+        const Side side = sideText == "for" ? Side::For : Side::Against;
+
+        const auto code = tokens.next();
+        const Team team = teamOf(code);
+        if (team != Team::None) {
+            return tokens.empty() ? make(side, MarketKind::Result, team, Team::None, 0) : MarketKey {};
+        }
+
+        for (const auto &spec : kKinds) {
+            if (spec.code != code) {
+                continue;
+            }
+
+            Team teams[2] = { Team::None, Team::None };
+            for (int i = 0; i < spec.teams; ++i) {
+                if (tokens.empty() || (teams[i] = teamOf(tokens.next())) == Team::None) {
+                    return {};
+                }
+            }
+
+            int32_t line = 0;
+            if (spec.line && (tokens.empty() || parseLine(tokens.next(), line) == false)) {
+                return {};
+            }
+            return tokens.empty() ? make(side, spec.kind, teams[0], teams[1], line) : MarketKey {};
+        }
+        return {};
+    }
+
+    //---------------------------------
+    MarketKeyCache::MarketKeyCache(std::size_t slots) {
+        std::size_t size = 1;
+        while (size < slots) {
+            size *= 2;
+        }
+        mSlots.resize(size);
+    }
+
+    //---------------------------------
+    MarketKey
+    MarketKeyCache::get(std::string_view betType) {
+        const uint32_t hash = MindShake::hashBytes(betType, 0);
+        Slot &slot = mSlots[hash & (mSlots.size() - 1)];
+        if (slot.hash == hash && slot.size == betType.size() && std::memcmp(slot.text, betType.data(), betType.size()) == 0) {
+            ++mStats.hits;
+            return slot.key;
+        }
+
+        const MarketKey key = MarketKey::parse(betType);
+        ++mStats.misses;
+        mStats.unknown += key.isValid() == false;
+
+        if (betType.empty() == false && betType.size() <= kMaxText) {
+            slot.hash = hash;
+            slot.size = uint8_t(betType.size());
+            slot.key  = key;
+            std::memcpy(slot.text, betType.data(), betType.size());
+        }
+        return key;
+    }
+
+} // end of namespace
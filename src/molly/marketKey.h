@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+//-------------------------------------
+namespace Molly {
+
+    //---------------------------------
+    enum class Side : uint8_t {
+        For,
+        Against,
+    };
+
+    //---------------------------------
+    enum class MarketKind : uint8_t {
+        Unknown,
+        Result,             // for,h / for,a / for,d
+        MoneyLine,          // for,ml,h
+        AsianHandicap,      // for,ah,h,-2
+        TotalOver,          // for,to,5 / for,ahover,5
+        TotalUnder,         // for,tu,5 / for,ahunder,5
+        TeamTotalOver,      // for,tahover,h,5
+        TeamTotalUnder,     // for,tahunder,h,5
+        DoubleChance,       // for,dc,h,d
+    };
+
+    //---------------------------------
+    enum class Team : uint8_t {
+        None,
+        Home,
+        Away,
+        Draw,
+    };
+
+    // A bet_type packed into 64 bits, for indexing and comparing markets
+    // without their text: side, kind, up to two teams and the line, kept
+    // in the bet_type's own units (quarters: "-2" is -0.5).
+    //   bits 63-56 side, 55-48 kind, 47-40 team, 39-32 second team, 31-0 line
+    //---------------------------------
+    struct MarketKey {
+        uint64_t    value {};       // Kind Unknown: not understood
+
+        static constexpr MarketKey make(Side side, MarketKind kind, Team team, Team other, int32_t line) {
+            return MarketKey { uint64_t(side) << 56 | uint64_t(kind) << 48 | uint64_t(team) << 40 | uint64_t(other) << 32 | uint32_t(line) };
+        }
+
+        // "for,ah,h,-2"; an Unknown key if it does not follow the grammar
+        static MarketKey parse(std::string_view betType);
+
+        constexpr Side          side() const        { return Side(value >> 56); }
+        constexpr MarketKind    kind() const        { return MarketKind(uint8_t(value >> 48)); }
+        constexpr Team          team() const        { return Team(uint8_t(value >> 40)); }
+        constexpr Team          otherTeam() const   { return Team(uint8_t(value >> 32)); }
+        constexpr int32_t       line() const        { return int32_t(uint32_t(value)); }
+        constexpr bool          isValid() const     { return kind() != MarketKind::Unknown; }
+
+        constexpr bool  operator==(MarketKey other) const   { return value == other.value; }
+        constexpr bool  operator!=(MarketKey other) const   { return value != other.value; }
+        constexpr bool  operator<(MarketKey other) const    { return value <  other.value; }
+    };
+
+    // bet_type text and its key, as decoded from a message
+    //---------------------------------
+    struct BetType {
+        std::string_view    text;
+        MarketKey           key;
+    };
+
+    //---------------------------------
+    struct MarketKeyStats {
+        uint64_t    hits {};
+        uint64_t    misses {};          // Parsed
+        uint64_t    unknown {};         // Of them, not understood
+
+        MarketKeyStats &operator+=(const MarketKeyStats &other) {
+            hits    += other.hits;
+            misses  += other.misses;
+            unknown += other.unknown;
+            return *this;
+        }
+    };
+
+    // Direct mapped cache of parsed bet_types: a market seen before costs
+    // one hash and one compare. A collision just replaces the slot, so it
+    // never grows; texts too long for a slot are parsed every time.
+    // Not thread safe.
+    //---------------------------------
+    class MarketKeyCache {
+        public:
+            static constexpr std::size_t kMaxText = 22;
+
+        public:
+            explicit    MarketKeyCache(std::size_t slots = 1024);
+
+            MarketKey   get(std::string_view betType);
+
+            const MarketKeyStats &getStats() const  { return mStats; }
+
+        protected:
+            struct Slot {
+                uint32_t    hash {};
+                uint8_t     size {};            // 0: empty
+                char        text[kMaxText];
+                MarketKey   key;
+            };
+
+        protected:
+            std::vector<Slot>   mSlots;
+            MarketKeyStats      mStats;
+    };
+
+} // end of namespace
+
+//-------------------------------------
+template <>
+struct std::hash<Molly::MarketKey> {
+    std::size_t operator()(Molly::MarketKey key) const noexcept { return std::hash<uint64_t>()(key.value); }
+};
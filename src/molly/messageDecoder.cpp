@@ -0,0 +1,464 @@
+#include "messageDecoder.h"
+#include "utils/perfectHash.h"
+//--
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+//-------------------------------------
+namespace Molly {
+
+    // Schemas: per message type, the field names with their perfect hash,
+    // find() from a key to its index and assign() from an index to the
+    // member, both generated from messages.schema as switch statements.
+    //---------------------------------
+    template <typename T>
+    struct Schema;
+
+} // end of namespace
+
+// Schema<Event>, Schema<Offer>... and kTypeNames
+#include "molly/messageSchemas.gen.h"
+
+//-------------------------------------
+namespace Molly {
+
+    //---------------------------------
+    template <typename T>
+    struct FieldTable {
+        static constexpr auto &kHash = Schema<T>::kHash;
+
+        static_assert(kHash.valid, "Field names must be unique");
+        static_assert(kHash.keys.size() <= kMaxFields, "Raise kMaxFields");
+        static_assert(kHash.keys.size() <= sizeof(FieldMask) * 8, "A bit per field");
+
+        static std::string_view getName(std::size_t field) {
+            return field < kHash.keys.size() ? kHash.keys[field] : std::string_view();
+        }
+    };
+
+    // FieldTable<T>::getName per MessageType, in Message order
+    //---------------------------------
+    template <std::size_t... Type>
+    constexpr std::array<std::string_view (*)(std::size_t), sizeof...(Type)>
+    fieldNameTable(std::index_sequence<Type...>) {
+        return { &FieldTable<std::variant_alternative_t<Type, Message>>::getName... };
+    }
+
+    static constexpr auto kFieldNames = fieldNameTable(std::make_index_sequence<std::size_t(MessageType::Count)>());
+
+    static constexpr auto kTypeHash = MindShake::makePerfectHash(kTypeNames);
+
+    static_assert(kTypeHash.valid, "Message tags must be unique");
+
+    // Fields a MessageFilter looks at, by type
+    //---------------------------------
+    template <typename T, typename = void>
+    struct HasSport : std::false_type {};
+
+    template <typename T>
+    struct HasSport<T, std::void_t<decltype(&T::sport)>> : std::true_type {};
+
+    template <typename T, typename = void>
+    struct HasBookie : std::false_type {};
+
+    template <typename T>
+    struct HasBookie<T, std::void_t<decltype(&T::bookie)>> : std::true_type {};
+
+    template <typename T, typename = void>
+    struct HasCompetition : std::false_type {};
+
+    template <typename T>
+    struct HasCompetition<T, std::void_t<decltype(&T::competitionId)>> : std::true_type {};
+
+    //---------------------------------
+    MessageDecoder::MessageDecoder() {
+        mSubscribed.fill(true);
+    }
+
+    //---------------------------------
+    void
+    MessageDecoder::subscribe(std::initializer_list<MessageType> types) {
+        mSubscribed.fill(types.size() == 0);
+        for (auto type : types) {
+            mSubscribed[std::size_t(type)] = true;
+        }
+    }
+
+    //---------------------------------
+    void
+    MessageDecoder::setFilter(const MessageFilter &filter) {
+        mFilter = filter;
+        for (std::size_t type = 0; type < mSubscribed.size(); ++type) {
+            mSubscribed[type] = filter.accepts(MessageType(type));
+        }
+    }
+
+    //---------------------------------
+    MessageType
+    MessageDecoder::getType(std::string_view tag) {
+        // kNotFound is Count
+        return MessageType(kTypeHash.find(tag));
+    }
+
+    //---------------------------------
+    const char *
+    MessageDecoder::getName(MessageType type) {
+        return type < MessageType::Count ? kTypeNames[std::size_t(type)].data() : "unknown";
+    }
+
+    //---------------------------------
+    std::string_view
+    MessageDecoder::getFieldName(MessageType type, std::size_t field) {
+        return type < MessageType::Count ? kFieldNames[std::size_t(type)](field) : std::string_view();
+    }
+
+    //---------------------------------
+    bool
+    MessageDecoder::decode(std::string_view frame, const Handler &handler) {
+        mFrameTs     = 0;
+        mScratchUsed = 0;
+        mError       = nullptr;
+
+        if (mTrusted == false && Utf8Validator::validate(frame) == false) {
+            mError = "frame is not UTF-8";
+            ++mStats.badFrames;
+            ++mStats.badUtf8;
+            return false;
+        }
+        if (mTape.parse(frame) == false) {
+            mError = mTape.getError();
+            ++mStats.badFrames;
+            return false;
+        }
+        if (mTape[0].kind != JsonTape::Kind::Object) {
+            mError = "frame is not an object";
+            ++mStats.badFrames;
+            return false;
+        }
+
+        for (auto key = JsonTape::first(0); key < mTape.end(0); key = mTape.next(key + 1)) {
+            const auto name  = mTape.raw(key);
+            const auto value = key + 1;
+            if (name == "ts") {
+                read(value, mFrameTs);
+                continue;
+            }
+            if (name != "data" || mTape[value].kind != JsonTape::Kind::Array) {
+                continue;
+            }
+
+            for (auto element = JsonTape::first(value); element < mTape.end(value); element = mTape.next(element)) {
+                decodeElement(element, handler);
+            }
+        }
+        return true;
+    }
+
+    //---------------------------------
+    bool
+    MessageDecoder::decodeMessage(std::string_view element, const Handler &handler) {
+        mScratchUsed = 0;
+        mError       = nullptr;
+
+        if (mTrusted == false && Utf8Validator::validate(element) == false) {
+            mError = "element is not UTF-8";
+            ++mStats.malformed;
+            ++mStats.badUtf8;
+            return false;
+        }
+        if (mTape.parse(element) == false) {
+            mError = mTape.getError();
+            ++mStats.malformed;
+            return false;
+        }
+        decodeElement(0, handler);
+        return true;
+    }
+
+    //---------------------------------
+    void
+    MessageDecoder::decodeElement(std::size_t element, const Handler &handler) {
+        const auto tag     = JsonTape::first(element);
+        const auto payload = tag + 1;
+        if (mTape[element].kind != JsonTape::Kind::Array || payload >= mTape.end(element) ||
+            mTape[tag].kind != JsonTape::Kind::String || mTape[payload].kind != JsonTape::Kind::Object) {
+            ++mStats.malformed;
+            return;
+        }
+
+        const auto type = getType(mTape.raw(tag));
+        if (type == MessageType::Count) {
+            ++mStats.unknown;
+            return;
+        }
+        if (mSubscribed[std::size_t(type)] == false) {
+            ++mStats.skipped;
+            mFilterStats.types.skips += mFilter.byType();
+            return;
+        }
+        mFilterStats.types.hits += mFilter.byType();
+
+        switch (type) {
+            case MessageType::Event:    decodeAs<Event>(payload, handler);      break;
+            case MessageType::Offer:    decodeAs<Offer>(payload, handler);      break;
+            case MessageType::Sync:     decodeAs<Sync>(payload, handler);       break;
+            case MessageType::Pmm:      decodeAs<Pmm>(payload, handler);        break;
+            case MessageType::Bet:      decodeAs<Bet>(payload, handler);        break;
+            case MessageType::Balance:  decodeAs<Balance>(payload, handler);    break;
+            case MessageType::Xrate:    decodeAs<Xrate>(payload, handler);      break;
+            default:                                                            break;
+        }
+    }
+
+    // Looks only at the filtered fields, with no decoding past a code
+    // lookup. A record lacking one of them is a partial update: it passes
+    // if the record it updates did, i.e. its event is known.
+    //---------------------------------
+    template <typename T>
+    bool
+    MessageDecoder::passes(std::size_t payload) {
+        const bool bySport       = HasSport<T>::value && mFilter.bySport();
+        const bool byBookie      = HasBookie<T>::value && mFilter.byBookie();
+        const bool byCompetition = HasCompetition<T>::value && mFilter.byCompetition();
+        if ((bySport || byBookie || byCompetition) == false) {
+            return true;
+        }
+
+        bool sportOk = true, bookieOk = true, competitionOk = true;
+        bool sportLeft = bySport, bookieLeft = byBookie, competitionLeft = byCompetition;
+        bool failed = false;
+        std::size_t eventId = 0;
+        for (auto key = JsonTape::first(payload); key < mTape.end(payload); key = mTape.next(key + 1)) {
+            const auto name  = mTape.raw(key);
+            const auto value = key + 1;
+            if (sportLeft && name == "sport") {
+                sportLeft = false;
+                sportOk   = mTape[value].kind == JsonTape::Kind::String && mFilter.accepts(findCode<Sport>(mTape.raw(value)));
+            }
+            else if (bookieLeft && name == "bookie") {
+                bookieLeft = false;
+                bookieOk   = mTape[value].kind == JsonTape::Kind::String && mFilter.accepts(findCode<Bookie>(mTape.raw(value)));
+            }
+            else if (competitionLeft && name == "competition_id") {
+                competitionLeft = false;
+                int64_t id;
+                competitionOk   = mTape.getInteger(value, id) && mFilter.acceptsCompetition(id);
+            }
+            else if (eventId == 0 && mKnown && name == "event_id") {
+                eventId = value;
+            }
+
+            failed = (sportOk && bookieOk && competitionOk) == false;
+            if (failed || ((sportLeft || bookieLeft || competitionLeft) == false)) {
+                break;
+            }
+        }
+
+        if (failed == false && mKnown && (sportLeft || bookieLeft || competitionLeft)) {
+            std::string_view id;
+            const bool known = eventId != 0 && read(eventId, id) && mKnown(id);
+            sportOk       = sportLeft == false || known;
+            bookieOk      = bookieLeft == false || known;
+            competitionOk = competitionLeft == false || known;
+        }
+
+        // Up to the first filter that failed
+        const auto count = [](FilterStats::Counter &counter, bool active, bool ok) {
+            if (active) {
+                ok ? ++counter.hits : ++counter.skips;
+            }
+            return active == false || ok;
+        };
+        return count(mFilterStats.sports, bySport, sportOk) &&
+               count(mFilterStats.bookies, byBookie, bookieOk) &&
+               count(mFilterStats.competitions, byCompetition, competitionOk);
+    }
+
+    //---------------------------------
+    template <typename T>
+    void
+    MessageDecoder::decodeAs(std::size_t payload, const Handler &handler) {
+        using Fields = Schema<T>;
+        constexpr auto &table = FieldTable<T>::kHash;
+
+        if (passes<T>(payload) == false) {
+            ++mStats.skipped;
+            return;
+        }
+
+        // Keys in a learned order cost one compare, others one hash and
+        // one compare; unknown keys usually no compare at all
+        auto &message = mMessage.emplace<T>();
+        auto &errors  = mStats.fieldErrors[mMessage.index()];
+        auto &shapes  = mShapes[mMessage.index()];
+        bool  valid   = true;
+        FieldMask fields = 0;
+        const Shape *shape = mSpeculative && shapes.count != 0 ? &shapes.shapes[shapes.hot] : nullptr;
+        std::array<uint8_t, kMaxShapeKeys> seen;
+        std::size_t position = 0;
+
+        const auto expects = [&](const Shape &candidate, std::string_view name) {
+            return candidate.fields[position] != Fields::kNotFound ? name == table.keys[candidate.fields[position]] : Fields::find(name) == Fields::kNotFound;
+        };
+        // Another learned order with the keys seen so far, and this one next
+        // (or ending here without name)
+        const auto other = [&](const std::string_view *name) -> const Shape * {
+            for (std::size_t i = 0; i < shapes.count && position <= kMaxShapeKeys; ++i) {
+                const auto &candidate = shapes.shapes[i];
+                if (&candidate != shape && (name ? candidate.size > position && expects(candidate, *name) : candidate.size == position) &&
+                    std::equal(seen.begin(), seen.begin() + position, candidate.fields.begin())) {
+                    return &candidate;
+                }
+            }
+            return nullptr;
+        };
+
+        for (auto key = JsonTape::first(payload); key < mTape.end(payload); key = mTape.next(key + 1), ++position) {
+            const auto name = mTape.raw(key);
+            if (shape != nullptr && (position >= shape->size || expects(*shape, name) == false)) {
+                shape = other(&name);
+            }
+            const std::size_t index = shape != nullptr ? shape->fields[position] : Fields::find(name);
+            if (position < kMaxShapeKeys) {
+                seen[position] = uint8_t(index);
+            }
+
+            if (index == Fields::kNotFound || mTape[key + 1].kind == JsonTape::Kind::Null) {
+                continue;
+            }
+            if (Fields::assign(message, *this, index, key + 1) == false) {
+                ++errors[index];
+                valid = false;
+            }
+            fields |= FieldMask(1) << index;
+        }
+
+        // New orders fill the free slots, then replace the least recently
+        // hit one once they keep missing
+        if (mSpeculative) {
+            if (shape != nullptr && position != shape->size) {
+                shape = other(nullptr);
+            }
+            if (shape != nullptr) {
+                ++mStats.shapeHits;
+                auto &hit  = shapes.shapes[std::size_t(shape - shapes.shapes.data())];
+                hit.used   = ++shapes.clock;
+                shapes.hot = uint8_t(&hit - shapes.shapes.data());
+                shapes.misses = 0;
+            }
+            else {
+                ++mStats.shapeMisses;
+                if ((shapes.count < kShapesPerType || ++shapes.misses >= kRelearnAfter) && position <= kMaxShapeKeys) {
+                    auto *slot = shapes.count < kShapesPerType ? &shapes.shapes[shapes.count++] :
+                                 std::min_element(shapes.shapes.begin(), shapes.shapes.end(), [](const Shape &a, const Shape &b) { return a.used < b.used; });
+                    std::copy_n(seen.begin(), position, slot->fields.begin());
+                    slot->size    = uint8_t(position);
+                    slot->used    = ++shapes.clock;
+                    shapes.hot    = uint8_t(slot - shapes.shapes.data());
+                    shapes.misses = 0;
+                }
+            }
+        }
+
+        if (valid == false) {
+            ++mStats.rejected[mMessage.index()];
+            return;
+        }
+        ++mStats.decoded[mMessage.index()];
+        handler(mMessage, fields);
+    }
+
+    //---------------------------------
+    bool
+    MessageDecoder::read(std::size_t node, std::string_view &out) {
+        if (mTape[node].kind != JsonTape::Kind::String) {
+            return false;
+        }
+
+        const auto raw = mTape.raw(node);
+        if (raw.find('\\') == std::string_view::npos) {
+            out = raw;
+            return true;
+        }
+
+        // A deque keeps earlier strings in place while it grows
+        if (mScratchUsed == mScratch.size()) {
+            mScratch.emplace_back();
+        }
+        auto &text = mScratch[mScratchUsed++];
+        text.clear();
+        if (JsonTape::unescape(raw, text) == false) {
+            return false;
+        }
+        out = text;
+        return true;
+    }
+
+    //---------------------------------
+    bool
+    MessageDecoder::read(std::size_t node, double &out) const {
+        return mTape.getNumber(node, out);
+    }
+
+    // Straight from the number bytes, no strtod
+    //---------------------------------
+    bool
+    MessageDecoder::read(std::size_t node, Decimal &out) const {
+        return mTape[node].kind == JsonTape::Kind::Number && Decimal::parse(mTape.raw(node), out);
+    }
+
+    // ISO-8601 text or epoch seconds
+    //---------------------------------
+    bool
+    MessageDecoder::read(std::size_t node, Timestamp &out) const {
+        switch (mTape[node].kind) {
+            case JsonTape::Kind::String:    return Timestamp::parseIso8601(mTape.raw(node), out);
+            case JsonTape::Kind::Number:    return Timestamp::parseEpoch(mTape.raw(node), out);
+            default:                        return false;
+        }
+    }
+
+    //---------------------------------
+    bool
+    MessageDecoder::read(std::size_t node, int64_t &out) const {
+        return mTape.getInteger(node, out);
+    }
+
+    //---------------------------------
+    bool
+    MessageDecoder::read(std::size_t node, bool &out) const {
+        const auto kind = mTape[node].kind;
+        if (kind != JsonTape::Kind::True && kind != JsonTape::Kind::False) {
+            return false;
+        }
+        out = kind == JsonTape::Kind::True;
+        return true;
+    }
+
+    //---------------------------------
+    bool
+    MessageDecoder::read(std::size_t node, Amount &out) {
+        const auto currency = JsonTape::first(node);
+        if (mTape[node].kind != JsonTape::Kind::Array || currency == mTape.end(node)) {
+            return false;
+        }
+        const auto value = mTape.next(currency);
+        if (value == mTape.end(node)) {
+            return false;
+        }
+        return read(currency, out.currency) && read(value, out.value);
+    }
+
+    // A bet_type not understood keeps an Unknown key; the record is fine
+    //---------------------------------
+    bool
+    MessageDecoder::read(std::size_t node, BetType &out) {
+        if (read(node, out.text) == false) {
+            return false;
+        }
+        out.key = mMarkets.get(out.text);
+        return true;
+    }
+
+} // end of namespace
@@ -0,0 +1,189 @@
+#pragma once
+
+#include "messages.h"
+#include "messageFilter.h"
+#include "feed/jsonTape.h"
+#include "feed/utf8Validator.h"
+//--
+#include <array>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <string>
+
+//-------------------------------------
+namespace Molly {
+
+    //---------------------------------
+    struct MessageStats {
+        using PerType = std::array<uint64_t, std::size_t(MessageType::Count)>;
+
+        PerType     decoded {};     // Per MessageType
+        PerType     rejected {};    // Records with a bad field, not delivered
+        std::array<std::array<uint64_t, kMaxFields>, std::size_t(MessageType::Count)>  fieldErrors {};  // Per type and schema field
+        uint64_t    skipped {};     // Not subscribed or filtered out
+        uint64_t    unknown {};     // Type tag with no schema
+        uint64_t    malformed {};   // Records not shaped ["type", {...}]
+        uint64_t    badFrames {};   // Frames that did not parse
+        uint64_t    badUtf8 {};     // Frames or elements that are not UTF-8, counted above too
+        uint64_t    shapeHits {};   // Records whose keys came in the learned order
+        uint64_t    shapeMisses {}; // Records that fell back to the lookups
+
+        MessageStats &operator+=(const MessageStats &other) {
+            for (std::size_t type = 0; type < decoded.size(); ++type) {
+                decoded[type]  += other.decoded[type];
+                rejected[type] += other.rejected[type];
+                for (std::size_t field = 0; field < kMaxFields; ++field) {
+                    fieldErrors[type][field] += other.fieldErrors[type][field];
+                }
+            }
+            skipped   += other.skipped;
+            unknown   += other.unknown;
+            malformed += other.malformed;
+            badFrames += other.badFrames;
+            badUtf8   += other.badUtf8;
+            shapeHits   += other.shapeHits;
+            shapeMisses += other.shapeMisses;
+            return *this;
+        }
+    };
+
+    // Decodes stream frames straight into typed messages. Each type has
+    // a schema (field name -> member) generated from messages.schema; the frame is
+    // read through the SIMD tape, and only subscribed types are decoded.
+    //
+    // Nothing throws: a record with a field of the wrong type is counted
+    // (MessageStats::fieldErrors) and skipped, the rest of the frame goes on.
+    // A null field keeps its default and is not in the FieldMask given to
+    // the handler, so updates that carry only what changed can be merged
+    // (MessageStore).
+    //
+    // A MessageFilter drops records on a few fields (sport, bookie...)
+    // before the rest of them is decoded; see getFilterStats. Records
+    // lacking one of those fields are partial updates: they pass only if
+    // setKnownEvents says their event_id passed before (all do without it).
+    //
+    // Records of a type mostly come with the same keys in the same order,
+    // or in one of a few (full records, partial updates). Those orders are
+    // learned per type, and keys are first compared against them, without
+    // the hash lookup: against the last one that matched, then, at a
+    // mismatch, against another with the same keys so far. When none
+    // agrees the rest of the record goes through the lookups
+    // (setSpeculative(false) always does).
+    //
+    // Input is checked to be UTF-8 (feed/Utf8Validator) unless trusted,
+    // e.g. when the WebSocket layer has already done it.
+    //---------------------------------
+    class MessageDecoder {
+        public:
+            // fields: those the record carried, the others keep their default
+            using Handler = std::function<void(const Message &message, FieldMask fields)>;
+            using KnownFunc = std::function<bool(std::string_view eventId)>;
+
+        public:
+                        MessageDecoder();
+
+            // Types to decode; none means all of them
+            void        subscribe(std::initializer_list<MessageType> types);
+
+            // Types, sports... to decode; replaces the subscription
+            void        setFilter(const MessageFilter &filter);
+
+            // Usually MessageStore::findEvent. Without it (e.g. decoding off
+            // the thread that owns the store), partial updates pass, and
+            // MessageStore::setFilter keeps them from creating records.
+            void        setKnownEvents(KnownFunc known)     { mKnown = std::move(known); }
+
+            void        setTrusted(bool trusted)        { mTrusted = trusted; }
+            void        setSpeculative(bool speculative)    { mSpeculative = speculative; }
+
+            // handler runs once per valid message, in frame order. False if
+            // the frame is malformed; nothing was delivered then.
+            bool        decode(std::string_view frame, const Handler &handler);
+
+            // One ["type", {payload}] element on its own, as given by
+            // IncrementalScanner. False if it does not parse.
+            bool        decodeMessage(std::string_view element, const Handler &handler);
+
+            // Type of a raw tag, MessageType::Count if unknown
+            static MessageType  getType(std::string_view tag);
+            static const char  *getName(MessageType type);
+
+            // JSON name of a schema field, empty past the last one
+            static std::string_view getFieldName(MessageType type, std::size_t field);
+
+            double      getFrameTs() const              { return mFrameTs; }
+            const char *getLastError() const            { return mError; }
+            const MessageStats &getStats() const        { return mStats; }
+            const MarketKeyStats &getMarketStats() const    { return mMarkets.getStats(); }
+            const FilterStats &getFilterStats() const   { return mFilterStats; }
+            JsonTape   &getTape()                       { return mTape; }
+
+            // Used by the schemas to read values; false keeps the default
+            bool        read(std::size_t node, std::string_view &out);
+            bool        read(std::size_t node, double &out) const;
+            bool        read(std::size_t node, Decimal &out) const;
+            bool        read(std::size_t node, Timestamp &out) const;
+            bool        read(std::size_t node, int64_t &out) const;
+            bool        read(std::size_t node, bool &out) const;
+            bool        read(std::size_t node, Amount &out);
+            bool        read(std::size_t node, BetType &out);
+
+            template <typename Enum>
+            bool        read(std::size_t node, Code<Enum> &out) {
+                if (read(node, out.text) == false) {
+                    return false;
+                }
+                out.value = findCode<Enum>(out.text);
+                return true;
+            }
+
+        protected:
+            void        decodeElement(std::size_t element, const Handler &handler);
+
+            template <typename T>
+            bool        passes(std::size_t payload);
+
+            template <typename T>
+            void        decodeAs(std::size_t payload, const Handler &handler);
+
+        protected:
+            // Learned key order: schema field per position, the field count
+            // for keys not in the schema
+            static constexpr std::size_t kMaxShapeKeys  = 32;
+            static constexpr std::size_t kShapesPerType = 4;
+            static constexpr uint8_t     kRelearnAfter  = 4;    // Misses in a row, once all are learned
+
+            struct Shape {
+                std::array<uint8_t, kMaxShapeKeys>  fields {};
+                uint8_t     size {};
+                uint32_t    used {};    // ShapeSet::clock of its last hit
+            };
+
+            struct ShapeSet {
+                std::array<Shape, kShapesPerType>   shapes {};
+                uint8_t     count {};
+                uint8_t     hot {};     // Last hit, tried first
+                uint8_t     misses {};
+                uint32_t    clock {};
+            };
+
+        protected:
+            JsonTape                    mTape;
+            Message                     mMessage;
+            std::array<bool, std::size_t(MessageType::Count)>  mSubscribed {};
+            MessageStats                mStats;
+            MessageFilter               mFilter;
+            KnownFunc                   mKnown;
+            FilterStats                 mFilterStats;
+            MarketKeyCache              mMarkets;
+            double                      mFrameTs {};
+            const char                  *mError {};
+            bool                        mTrusted {};
+            bool                        mSpeculative { true };
+            std::array<ShapeSet, std::size_t(MessageType::Count)>   mShapes {};
+            std::deque<std::string>     mScratch;       // Unescaped strings of the current frame
+            std::size_t                 mScratchUsed {};
+    };
+
+} // end of namespace
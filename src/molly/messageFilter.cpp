@@ -0,0 +1,24 @@
+#include "messageFilter.h"
+//--
+#include <algorithm>
+
+//-------------------------------------
+namespace Molly {
+
+    //---------------------------------
+    MessageFilter &
+    MessageFilter::addCompetition(int64_t id) {
+        const auto it = std::lower_bound(mCompetitions.begin(), mCompetitions.end(), id);
+        if (it == mCompetitions.end() || *it != id) {
+            mCompetitions.insert(it, id);
+        }
+        return *this;
+    }
+
+    //---------------------------------
+    bool
+    MessageFilter::acceptsCompetition(int64_t id) const {
+        return std::binary_search(mCompetitions.begin(), mCompetitions.end(), id);
+    }
+
+} // end of namespace
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "messages.h"
+//--
+#include <array>
+#include <cstdint>
+#include <vector>
+
+//-------------------------------------
+namespace Molly {
+
+    //---------------------------------
+    struct FilterStats {
+        struct Counter {
+            uint64_t    hits {};        // Records that passed
+            uint64_t    skips {};       // Records dropped undecoded
+        };
+
+        Counter     types;
+        Counter     sports;
+        Counter     competitions;
+        Counter     bookies;
+
+        FilterStats &operator+=(const FilterStats &other) {
+            for (auto [to, from] : { std::pair { &types, &other.types }, { &sports, &other.sports }, { &competitions, &other.competitions }, { &bookies, &other.bookies } }) {
+                to->hits  += from->hits;
+                to->skips += from->skips;
+            }
+            return *this;
+        }
+    };
+
+    // What a consumer wants, given to the decoder so that the rest is
+    // dropped before it is decoded: only the few fields the filter needs
+    // are looked at. Each part with nothing added lets everything through;
+    // a part applies only to the types that have its field (competition
+    // ids: events; bookies: offers and bets). Records without the field,
+    // like partial updates, pass when the decoder knows their event
+    // (MessageDecoder::setKnownEvents).
+    //---------------------------------
+    class MessageFilter {
+        public:
+            MessageFilter &addType(MessageType type)        { mTypes[std::size_t(type)] = true; mByType = true; return *this; }
+            MessageFilter &addSport(Sport sport)            { mSports |= 1u << unsigned(sport); return *this; }
+            MessageFilter &addBookie(Bookie bookie)         { mBookies |= 1u << unsigned(bookie); return *this; }
+            MessageFilter &addCompetition(int64_t id);
+
+            bool        byType() const                      { return mByType; }
+            bool        bySport() const                     { return mSports != 0; }
+            bool        byBookie() const                    { return mBookies != 0; }
+            bool        byCompetition() const               { return mCompetitions.empty() == false; }
+
+            bool        accepts(MessageType type) const     { return mByType == false || mTypes[std::size_t(type)]; }
+            bool        accepts(Sport sport) const          { return sport != Sport::Count && (mSports >> unsigned(sport) & 1) != 0; }
+            bool        accepts(Bookie bookie) const        { return bookie != Bookie::Count && (mBookies >> unsigned(bookie) & 1) != 0; }
+            bool        acceptsCompetition(int64_t id) const;
+
+        protected:
+            static_assert(std::size_t(Sport::Count) <= 32 && std::size_t(Bookie::Count) <= 32, "Masks are 32 bits");
+
+            std::array<bool, std::size_t(MessageType::Count)>  mTypes {};
+            bool                    mByType {};
+            uint32_t                mSports {};         // Bit per Sport
+            uint32_t                mBookies {};        // Bit per Bookie
+            std::vector<int64_t>    mCompetitions;      // Sorted
+    };
+
+} // end of namespace
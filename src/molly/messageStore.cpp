@@ -0,0 +1,151 @@
+#include "messageStore.h"
+
+//-------------------------------------
+namespace Molly {
+
+    //---------------------------------
+    void
+    MessageStore::setFilter(const MessageFilter &filter) {
+        mEventRequired = (filter.bySport() ? Event::kSport : 0) | (filter.byCompetition() ? Event::kCompetitionId : 0);
+        mOfferRequired = filter.bySport() ? Offer::kSport : 0;
+    }
+
+    //---------------------------------
+    Applied
+    MessageStore::apply(const Event &event, FieldMask fields) {
+        if ((fields & Event::kEventId) == 0) {
+            return {};
+        }
+
+        // Not interned: it is a lookup only
+        if ((fields & mEventRequired) != mEventRequired) {
+            const auto it = mEvents.find(mText.find(event.eventId));
+            if (it == mEvents.end()) {
+                ++mStats.ignored;
+                return {};
+            }
+            return merge(it->second, event, fields, false);
+        }
+
+        const auto [it, created] = mEvents.try_emplace(mText.intern(event.eventId));
+        return merge(it->second, event, fields, created);
+    }
+
+    //---------------------------------
+    Applied
+    MessageStore::apply(const Offer &offer, FieldMask fields) {
+        constexpr FieldMask kKey = Offer::kEventId | Offer::kBetType | Offer::kBookie;
+        if ((fields & kKey) != kKey) {
+            return {};
+        }
+
+        if ((fields & mOfferRequired) != mOfferRequired) {
+            const auto it = mOffers.find(findKey(offer.eventId, offer.betType, offer.bookie));
+            if (it == mOffers.end()) {
+                ++mStats.ignored;
+                return {};
+            }
+            return merge(it->second, offer, fields, false);
+        }
+
+        // Unknown markets all share MarketKey{}, and unknown bookies
+        // Bookie::Count: their text keeps them apart
+        const auto unknownMarket = offer.betType.key.isValid() ? MindShake::StringInterner::kInvalid : mText.intern(offer.betType.text);
+        const auto unknownBookie = offer.bookie.isKnown() ? MindShake::StringInterner::kInvalid : mText.intern(offer.bookie.text);
+        const OfferKey key { mText.intern(offer.eventId), offer.betType.key, offer.bookie.value, unknownMarket, unknownBookie };
+        const auto [it, created] = mOffers.try_emplace(key);
+        return merge(it->second, offer, fields, created);
+    }
+
+    //---------------------------------
+    Applied
+    MessageStore::apply(const Message &message, FieldMask fields) {
+        if (const auto *event = std::get_if<Event>(&message)) {
+            return apply(*event, fields);
+        }
+        if (const auto *offer = std::get_if<Offer>(&message)) {
+            return apply(*offer, fields);
+        }
+        return {};
+    }
+
+    //---------------------------------
+    const Event *
+    MessageStore::findEvent(std::string_view eventId) const {
+        const auto it = mEvents.find(mText.find(eventId));
+        return it != mEvents.end() ? &it->second : nullptr;
+    }
+
+    //---------------------------------
+    const Offer *
+    MessageStore::findOffer(std::string_view eventId, const BetType &betType, std::string_view bookie) const {
+        const auto it = mOffers.find(findKey(eventId, betType, { bookie, findCode<Bookie>(bookie) }));
+        return it != mOffers.end() ? &it->second : nullptr;
+    }
+
+    // Text never interned finds nothing
+    //---------------------------------
+    MessageStore::OfferKey
+    MessageStore::findKey(std::string_view eventId, const BetType &betType, const BookieCode &bookie) const {
+        const auto unknownMarket = betType.key.isValid() ? MindShake::StringInterner::kInvalid : mText.find(betType.text);
+        const auto unknownBookie = bookie.isKnown() ? MindShake::StringInterner::kInvalid : mText.find(bookie.text);
+        return { mText.find(eventId), betType.key, bookie.value, unknownMarket, unknownBookie };
+    }
+
+    //---------------------------------
+    template <typename T>
+    Applied
+    MessageStore::merge(T &stored, const T &message, FieldMask fields, bool created) {
+        const auto changed = mergeFields(stored, message, fields, [this](auto &to, const auto &from) {
+            return copy(to, from);
+        });
+
+        ++(created ? mStats.created : mStats.updates);
+        for (auto bits = changed; bits != 0; bits &= bits - 1) {
+            ++mStats.changed;
+        }
+        return { changed, true, created };
+    }
+
+    //---------------------------------
+    template <typename V>
+    bool
+    MessageStore::copy(V &to, const V &from) {
+        if (to == from) {
+            return false;
+        }
+        to = from;
+        return true;
+    }
+
+    // Interned: the view outlives the frame
+    //---------------------------------
+    bool
+    MessageStore::copy(std::string_view &to, std::string_view from) {
+        if (to == from) {
+            return false;
+        }
+        to = mText.get(mText.intern(from));
+        return true;
+    }
+
+    //---------------------------------
+    bool
+    MessageStore::copy(Amount &to, const Amount &from) {
+        const bool currency = copy(to.currency, from.currency);
+        const bool value    = copy(to.value, from.value);
+        return currency || value;
+    }
+
+    //---------------------------------
+    bool
+    MessageStore::copy(BetType &to, const BetType &from) {
+        if (to.key == from.key && to.text == from.text) {
+            return false;
+        }
+        to.key = from.key;
+        copy(to.text, from.text);
+        return true;
+    }
+
+} // end of namespace
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "messages.h"
+#include "messageFilter.h"
+#include "utils/stringInterner.h"
+//--
+#include <cstdint>
+#include <unordered_map>
+
+//-------------------------------------
+namespace Molly {
+
+    //---------------------------------
+    struct StoreStats {
+        uint64_t    created {};     // Records seen for the first time
+        uint64_t    updates {};     // Messages merged into a stored record
+        uint64_t    changed {};     // Fields whose value changed, over both
+        uint64_t    ignored {};     // Updates to records never let in
+    };
+
+    // What apply() did with a message
+    //---------------------------------
+    struct Applied {
+        FieldMask   changed {};     // Fields whose value changed
+        bool        stored {};      // False if the message was ignored
+        bool        created {};     // Its record is new
+    };
+
+    // Current events and offers, built from the stream. A message only
+    // touches the fields it carried (the FieldMask from MessageDecoder), in
+    // place, and apply() returns those whose value actually changed, so
+    // consumers can limit what they recompute. Text is interned: stored
+    // records keep no view into frames.
+    //
+    // Events are keyed by event_id, offers by event_id, market and bookie;
+    // records without their key are ignored. Markets MarketKey does not
+    // understand, and bookies with no Bookie value, are told apart by their
+    // text. Not thread safe.
+    //
+    // With a filter, only messages carrying the fields it looks at create
+    // records; those lacking one (partial updates) merge into a stored
+    // record or are ignored, as the record they update was filtered out.
+    //---------------------------------
+    class MessageStore {
+        public:
+            using Id = MindShake::StringInterner::Id;
+
+        public:
+            // The same the decoder was given
+            void        setFilter(const MessageFilter &filter);
+
+            Applied     apply(const Event &event, FieldMask fields);
+            Applied     apply(const Offer &offer, FieldMask fields);
+            // Other types are not stored
+            Applied     apply(const Message &message, FieldMask fields);
+
+            const Event *findEvent(std::string_view eventId) const;
+            const Offer *findOffer(std::string_view eventId, const BetType &betType, std::string_view bookie) const;
+
+            std::size_t getEvents() const                   { return mEvents.size(); }
+            std::size_t getOffers() const                   { return mOffers.size(); }
+            const StoreStats &getStats() const              { return mStats; }
+
+        protected:
+            struct OfferKey {
+                Id          eventId;
+                MarketKey   market;
+                Bookie      bookie;
+                Id          unknownMarket;  // Interned bet_type when market is not valid
+                Id          unknownBookie;  // Interned code when bookie is Count
+
+                bool operator==(const OfferKey &other) const {
+                    return eventId == other.eventId && market == other.market && bookie == other.bookie &&
+                           unknownMarket == other.unknownMarket && unknownBookie == other.unknownBookie;
+                }
+            };
+
+            struct OfferKeyHash {
+                std::size_t operator()(const OfferKey &key) const {
+                    const uint64_t bookie = uint64_t(key.bookie) << 24 ^ key.unknownBookie;
+                    return std::hash<uint64_t>()((key.market.value ^ key.unknownMarket) ^ (uint64_t(key.eventId) << 32 | bookie) * 0x9E3779B97F4A7C15ull);
+                }
+            };
+
+            OfferKey    findKey(std::string_view eventId, const BetType &betType, const BookieCode &bookie) const;
+
+            template <typename T>
+            Applied     merge(T &stored, const T &message, FieldMask fields, bool created);
+
+            // copy() of mergeFields, one per field type; true if it changed
+            template <typename V>
+            bool        copy(V &to, const V &from);
+            bool        copy(std::string_view &to, std::string_view from);
+            bool        copy(Amount &to, const Amount &from);
+            bool        copy(BetType &to, const BetType &from);
+
+            template <typename Enum>
+            bool        copy(Code<Enum> &to, const Code<Enum> &from) {
+                if (to.value == from.value && to.text == from.text) {
+                    return false;
+                }
+                to.value = from.value;
+                copy(to.text, from.text);
+                return true;
+            }
+
+        protected:
+            MindShake::StringInterner                       mText;      // Owns the text of stored records
+            std::unordered_map<Id, Event>                   mEvents;    // By interned event_id
+            std::unordered_map<OfferKey, Offer, OfferKeyHash>   mOffers;
+            StoreStats                                      mStats;
+            FieldMask                                       mEventRequired {};  // To create a record
+            FieldMask                                       mOfferRequired {};
+    };
+
+} // end of namespace
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "codes.h"
+#include "marketKey.h"
+#include "feed/timestamp.h"
+#include "utils/decimal.h"
+//--
+#include <cstdint>
+#include <string_view>
+#include <variant>
+
+// Typed stream messages, generated from messages.schema by tools/schemaGen.
+// Field names follow the Molly stream docs; any other field is ignored by
+// the decoder.
+// Text fields point into the frame (or into decoder scratch when they
+// had escapes): they are only valid inside the handler call.
+//-------------------------------------
+namespace Molly {
+
+    // Prices, stakes, balances and rates are exact fixed-point
+    using MindShake::Decimal;
+
+    // ["EUR", 5.0]
+    //---------------------------------
+    struct Amount {
+        std::string_view    currency;
+        Decimal             value;
+    };
+
+    // Fields present in a record, one bit per schema field (Event::kHome...)
+    using FieldMask = uint32_t;
+
+} // end of namespace
+
+// Event, Offer... MessageType and Message, from messages.schema
+#include "molly/messages.gen.h"
+
+//-------------------------------------
+namespace Molly {
+
+    static_assert(std::variant_size_v<Message> == std::size_t(MessageType::Count), "MessageType and Message are out of sync");
+
+    // std::visit(Overloaded { [](const Event &) {}, [](const auto &) {} }, message);
+    //---------------------------------
+    template <typename ... Handlers>
+    struct Overloaded : Handlers ... {
+        using Handlers::operator() ...;
+    };
+
+    template <typename ... Handlers>
+    Overloaded(Handlers ...) -> Overloaded<Handlers ...>;
+
+} // end of namespace
@@ -0,0 +1,181 @@
+#include "parallelDecoder.h"
+//--
+#include <algorithm>
+
+//-------------------------------------
+namespace Molly {
+
+    //---------------------------------
+    ParallelDecoder::ParallelDecoder(MindShake::WorkerPool &workers, std::size_t maxInFlight)
+        : mWorkers(workers)
+    {
+        if (maxInFlight == 0) {
+            maxInFlight = 4 * std::max<std::size_t>(workers.size(), 1);
+        }
+
+        // One decoder per frame in flight: its scratch strings back the
+        // views of the messages until they are delivered
+        mDecoders.reserve(maxInFlight);
+        for (std::size_t i = 0; i < maxInFlight; ++i) {
+            mDecoders.emplace_back(std::make_unique<MessageDecoder>());
+            mIdle.push_back(mDecoders.back().get());
+        }
+    }
+
+    // Workers may still hold jobs
+    //---------------------------------
+    ParallelDecoder::~ParallelDecoder() {
+        std::unique_lock lock(mMutex);
+        for (auto &job : mPending) {
+            mDone.wait(lock, [&job]() { return job->done; });
+        }
+    }
+
+    //---------------------------------
+    void
+    ParallelDecoder::subscribe(std::initializer_list<MessageType> types) {
+        for (auto &decoder : mDecoders) {
+            decoder->subscribe(types);
+        }
+    }
+
+    //---------------------------------
+    void
+    ParallelDecoder::setFilter(const MessageFilter &filter) {
+        for (auto &decoder : mDecoders) {
+            decoder->setFilter(filter);
+        }
+    }
+
+    //---------------------------------
+    void
+    ParallelDecoder::setTrusted(bool trusted) {
+        for (auto &decoder : mDecoders) {
+            decoder->setTrusted(trusted);
+        }
+    }
+
+    //---------------------------------
+    void
+    ParallelDecoder::decode(std::string_view frame, const Handler &handler) {
+        if (mIdle.empty()) {
+            std::unique_lock lock(mMutex);
+            mDone.wait(lock, [this]() { return mPending.front()->done; });
+            lock.unlock();
+            deliver(handler);
+        }
+
+        std::unique_ptr<Job> job;
+        if (mSpare.empty()) {
+            job = std::make_unique<Job>();
+        }
+        else {
+            job = std::move(mSpare.back());
+            mSpare.pop_back();
+        }
+        job->frame.assign(frame.data(), frame.size());
+        job->decoder = mIdle.back();
+        job->done    = false;
+        mIdle.pop_back();
+
+        Job *work = job.get();
+        mPending.emplace_back(std::move(job));
+        mWorkers.post([this, work]() {
+            work->messages.clear();
+            work->ok    = work->decoder->decode(work->frame, [work](const Message &message, FieldMask fields) {
+                work->messages.emplace_back(message, fields);
+            });
+            work->error = work->decoder->getLastError();
+            work->ts    = work->decoder->getFrameTs();
+
+            std::lock_guard guard(mMutex);
+            work->done = true;
+            mDone.notify_all();
+        });
+
+        deliver(handler);
+    }
+
+    //---------------------------------
+    std::size_t
+    ParallelDecoder::deliver(const Handler &handler) {
+        std::size_t delivered = 0;
+        for (;;) {
+            {
+                std::lock_guard guard(mMutex);
+                if (mPending.empty() || mPending.front()->done == false) {
+                    break;
+                }
+            }
+            deliverFront(handler);
+            ++delivered;
+        }
+        return delivered;
+    }
+
+    //---------------------------------
+    void
+    ParallelDecoder::flush(const Handler &handler) {
+        while (mPending.empty() == false) {
+            {
+                std::unique_lock lock(mMutex);
+                mDone.wait(lock, [this]() { return mPending.front()->done; });
+            }
+            deliverFront(handler);
+        }
+    }
+
+    // The front job is done: the worker no longer touches it
+    //---------------------------------
+    void
+    ParallelDecoder::deliverFront(const Handler &handler) {
+        auto job = std::move(mPending.front());
+        mPending.pop_front();
+
+        if (job->ok == false) {
+            if (mOnInvalid) {
+                mOnInvalid(job->error);
+            }
+        }
+        else {
+            mFrameTs = job->ts;
+            for (const auto &[message, fields] : job->messages) {
+                handler(message, fields);
+            }
+        }
+
+        mIdle.push_back(job->decoder);
+        mSpare.emplace_back(std::move(job));
+    }
+
+    //---------------------------------
+    MessageStats
+    ParallelDecoder::getStats() const {
+        MessageStats stats;
+        for (const auto &decoder : mDecoders) {
+            stats += decoder->getStats();
+        }
+        return stats;
+    }
+
+    //---------------------------------
+    MarketKeyStats
+    ParallelDecoder::getMarketStats() const {
+        MarketKeyStats stats;
+        for (const auto &decoder : mDecoders) {
+            stats += decoder->getMarketStats();
+        }
+        return stats;
+    }
+
+    //---------------------------------
+    FilterStats
+    ParallelDecoder::getFilterStats() const {
+        FilterStats stats;
+        for (const auto &decoder : mDecoders) {
+            stats += decoder->getFilterStats();
+        }
+        return stats;
+    }
+
+} // end of namespace
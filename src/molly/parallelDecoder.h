@@ -0,0 +1,91 @@
+#pragma once
+
+#include "messageDecoder.h"
+#include "utils/workerPool.h"
+//--
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+//-------------------------------------
+namespace Molly {
+
+    // Decodes frames on a WorkerPool and hands the messages over on the
+    // calling thread, in arrival order: frames are decoded out of order
+    // but merged in sequence, so consumers see exactly what a single
+    // MessageDecoder would have delivered.
+    //
+    // Meant for the pre-sync burst, where one thread is the bottleneck.
+    // A frame's messages are delivered by a later decode(), deliver() or
+    // flush() call, so flush() once the burst is over.
+    // All calls but the workers' must come from one thread.
+    //---------------------------------
+    class ParallelDecoder {
+        public:
+            using Handler        = MessageDecoder::Handler;
+            using InvalidHandler = std::function<void(const char *error)>;
+
+        public:
+            // maxInFlight 0 means four frames per worker
+            explicit    ParallelDecoder(MindShake::WorkerPool &workers, std::size_t maxInFlight = 0);
+                        ~ParallelDecoder();
+
+            ParallelDecoder(const ParallelDecoder &) = delete;
+            ParallelDecoder &operator=(const ParallelDecoder &) = delete;
+
+            void        subscribe(std::initializer_list<MessageType> types);
+            void        setFilter(const MessageFilter &filter);
+            void        setInvalidHandler(InvalidHandler handler)  { mOnInvalid = std::move(handler); }
+            void        setTrusted(bool trusted);
+
+            // Copies frame for a worker, then delivers whatever is done.
+            // Waits for the oldest frame when maxInFlight are pending.
+            void        decode(std::string_view frame, const Handler &handler);
+
+            // Delivers the decoded frames at the front, without waiting
+            std::size_t deliver(const Handler &handler);
+
+            // Waits for every pending frame and delivers them
+            void        flush(const Handler &handler);
+
+            std::size_t getPending() const      { return mPending.size(); }
+
+            // Top level "ts" of the frame whose messages are being handed over
+            double      getFrameTs() const      { return mFrameTs; }
+
+            // Summed over the decoders; only once flushed
+            MessageStats getStats() const;
+            MarketKeyStats getMarketStats() const;
+            FilterStats getFilterStats() const;
+
+        protected:
+            struct Job {
+                std::string             frame;
+                MessageDecoder          *decoder {};    // Owns the unescaped strings until delivered
+                std::vector<std::pair<Message, FieldMask>>  messages;
+                const char              *error {};
+                double                  ts {};
+                bool                    ok {};
+                bool                    done {};        // Under mMutex
+            };
+
+        protected:
+            void        deliverFront(const Handler &handler);
+
+        protected:
+            MindShake::WorkerPool                           &mWorkers;
+            std::vector<std::unique_ptr<MessageDecoder>>    mDecoders;
+            std::vector<MessageDecoder *>                   mIdle;
+            std::deque<std::unique_ptr<Job>>                mPending;   // Arrival order
+            std::vector<std::unique_ptr<Job>>               mSpare;     // Keep their buffers
+            InvalidHandler                                  mOnInvalid;
+            double                                          mFrameTs {};
+
+            mutable std::mutex                              mMutex;
+            std::condition_variable                         mDone;
+    };
+
+} // end of namespace
@@ -0,0 +1,347 @@
+#include "httpsClient.h"
+#include "log/logger.h"
+//--
+#include <boost/beast/version.hpp>
+//--
+#include <algorithm>
+
+//-------------------------------------
+using namespace MindShake;
+
+//-------------------------------------
+HttpsClient::HttpsClient(net::io_context &ioc, ssl::context &ctx)
+    : HttpsClient(ioc, ctx, Options())
+{
+}
+
+//-------------------------------------
+HttpsClient::HttpsClient(net::io_context &ioc, ssl::context &ctx, const Options &options)
+    : mStrand(net::make_strand(ioc))
+    , mCtx(ctx)
+    , mResolver(mStrand)
+    , mPendingTimer(mStrand)
+    , mOptions(options)
+{
+    if (mOptions.maxConnectionsPerHost == 0) mOptions.maxConnectionsPerHost = 1;
+    if (mOptions.maxPipelineDepth == 0)      mOptions.maxPipelineDepth = 1;
+}
+
+//-------------------------------------
+std::string
+HttpsClient::makeRequest(http::verb verb, std::string_view host, std::string_view target, std::string_view body, const Headers &headers) {
+    std::string request;
+    request.reserve(256 + target.size() + body.size());
+
+    const auto method = http::to_string(verb);
+    request.append(method.data(), method.size());
+    request += ' ';
+    request += target;
+    request += " HTTP/1.1\r\nHost: ";
+    request += host;
+    request += "\r\nUser-Agent: " BOOST_BEAST_VERSION_STRING "\r\nConnection: keep-alive\r\n";
+    for (const auto &header : headers) {
+        request += header.first;
+        request += ": ";
+        request += header.second;
+        request += "\r\n";
+    }
+    if (body.empty() == false || verb == http::verb::post || verb == http::verb::put) {
+        request += "Content-Type: application/json\r\nContent-Length: ";
+        request += std::to_string(body.size());
+        request += "\r\n";
+    }
+    request += "\r\n";
+    request += body;
+
+    return request;
+}
+
+//-------------------------------------
+HttpsClient::Pool &
+HttpsClient::getPool(const std::string &host, const std::string &port) {
+    auto &pool = mPools[host + ':' + port];
+    if (pool.host.empty()) {
+        pool.host = host;
+        pool.port = port;
+    }
+    return pool;
+}
+
+//-------------------------------------
+void
+HttpsClient::warmUp(const std::string &host, const std::string &port, std::size_t connections, ReadyHandler onReady) {
+    net::post(mStrand, [self = shared_from_this(), host, port, connections, onReady = std::move(onReady)]() mutable {
+        auto &pool = self->getPool(host, port);
+        if (onReady) {
+            pool.onReady.emplace_back(std::move(onReady));
+        }
+
+        pool.warm = std::max(pool.warm, std::min(connections, self->mOptions.maxConnectionsPerHost));
+        if (pool.endpoints.empty()) {
+            return self->resolve(pool);
+        }
+
+        self->topUp(pool);
+        for (const auto &connection : pool.connections) {
+            if (connection->isOpen()) {
+                return self->notifyReady(pool, true);
+            }
+        }
+    });
+}
+
+//-------------------------------------
+void
+HttpsClient::topUp(Pool &pool) {
+    while (mStopped == false && pool.connections.size() < pool.warm) {
+        openConnection(pool);
+    }
+}
+
+//-------------------------------------
+void
+HttpsClient::async(const std::string &host, const std::string &port, HttpsRequest &&request) {
+    if (request.deadline == HttpsRequest::Clock::time_point::max()) {
+        request.deadline = HttpsRequest::Clock::now() + mOptions.defaultTimeout;
+    }
+
+    net::post(mStrand, [self = shared_from_this(), host, port, request = std::move(request)]() mutable {
+        if (self->mStopped) {
+            return request.handler(net::error::operation_aborted, {});
+        }
+
+        auto &pool = self->getPool(host, port);
+        pool.pending.emplace_back(std::move(request));
+        self->dispatch(pool);
+    });
+}
+
+//-------------------------------------
+void
+HttpsClient::resolve(Pool &pool) {
+    if (pool.resolving) {
+        return;
+    }
+
+    pool.resolving = true;
+    mResolver.async_resolve(pool.host, pool.port, [self = shared_from_this(), &pool](beast::error_code ec, tcp::resolver::results_type results) {
+        pool.resolving = false;
+        if (ec) {
+            Logger::error("HttpsClient: cannot resolve '{}': {}", pool.host, ec.message());
+            self->notifyReady(pool, false);
+            return self->failPending(pool, ec);
+        }
+
+        pool.endpoints = std::move(results);
+        self->topUp(pool);
+        self->dispatch(pool);
+    });
+}
+
+//-------------------------------------
+void
+HttpsClient::openConnection(Pool &pool) {
+    auto connection = std::make_shared<HttpsConnection>(mStrand, mCtx);
+    pool.connections.emplace_back(connection);
+
+    connection->setCloseHandler([self = shared_from_this(), &pool, weak = std::weak_ptr<HttpsConnection>(connection)](std::vector<HttpsRequest> &&retry) {
+        self->onClosed(pool, weak.lock(), std::move(retry));
+    });
+    connection->setAvailableHandler([self = shared_from_this(), &pool]() {
+        self->dispatch(pool);
+    });
+    connection->connect(pool.host, pool.endpoints, [self = shared_from_this(), &pool, connection](beast::error_code ec) {
+        self->onConnected(pool, connection, ec);
+    });
+}
+
+//-------------------------------------
+void
+HttpsClient::onConnected(Pool &pool, const std::shared_ptr<HttpsConnection> &connection, beast::error_code ec) {
+    if (ec) {
+        Logger::warning("HttpsClient: cannot connect to '{}': {}", pool.host, ec.message());
+        auto it = std::find(pool.connections.begin(), pool.connections.end(), connection);
+        if (it != pool.connections.end()) {
+            pool.connections.erase(it);
+        }
+
+        // Nothing else on the way: whoever waits would wait forever
+        if (pool.connections.empty()) {
+            notifyReady(pool, false);
+            failPending(pool, ec);
+        }
+        return;
+    }
+
+    if (mStopped) {
+        return connection->close();
+    }
+
+    notifyReady(pool, true);
+    dispatch(pool);
+}
+
+//-------------------------------------
+void
+HttpsClient::onClosed(Pool &pool, const std::shared_ptr<HttpsConnection> &connection, std::vector<HttpsRequest> &&retry) {
+    auto it = std::find(pool.connections.begin(), pool.connections.end(), connection);
+    if (it != pool.connections.end()) {
+        pool.connections.erase(it);
+    }
+
+    // Back to the front, keeping their order
+    for (auto rit = retry.rbegin(); rit != retry.rend(); ++rit) {
+        pool.pending.emplace_front(std::move(*rit));
+    }
+
+    if (mStopped) {
+        return failPending(pool, net::error::operation_aborted);
+    }
+
+    // Keep warmed up pools warm
+    topUp(pool);
+    dispatch(pool);
+}
+
+// Requests past their deadline fail here instead of being written
+//-------------------------------------
+void
+HttpsClient::dispatch(Pool &pool) {
+    expirePending(pool);
+    sendPending(pool);
+    armPendingTimer();
+}
+
+// Idle connections first, then the least loaded one below the pipeline
+// depth. A busy pool grows up to maxConnectionsPerHost meanwhile.
+//-------------------------------------
+void
+HttpsClient::sendPending(Pool &pool) {
+    if (pool.pending.empty()) {
+        return;
+    }
+    if (pool.endpoints.empty()) {
+        return resolve(pool);
+    }
+
+    bool connecting = false;
+    while (pool.pending.empty() == false) {
+        HttpsConnection *best = nullptr;
+        for (const auto &connection : pool.connections) {
+            if (connection->isOpen() == false) {
+                connecting = true;
+                continue;
+            }
+            if (connection->inFlight() < mOptions.maxPipelineDepth && connection->canPipeline(pool.pending.front()) &&
+                (best == nullptr || connection->inFlight() < best->inFlight())) {
+                best = connection.get();
+            }
+        }
+
+        if (best == nullptr || best->inFlight() != 0) {
+            if (connecting == false && pool.connections.size() < mOptions.maxConnectionsPerHost) {
+                openConnection(pool);
+                connecting = true;
+            }
+            if (best == nullptr) {
+                return;
+            }
+        }
+
+        best->send(std::move(pool.pending.front()));
+        pool.pending.pop_front();
+    }
+}
+
+//-------------------------------------
+void
+HttpsClient::failPending(Pool &pool, beast::error_code ec) {
+    auto pending = std::move(pool.pending);
+    pool.pending.clear();
+    for (auto &request : pending) {
+        request.handler(ec, {});
+    }
+    armPendingTimer();
+}
+
+//-------------------------------------
+void
+HttpsClient::expirePending(Pool &pool) {
+    const auto now = HttpsRequest::Clock::now();
+    std::vector<HttpsRequest> expired;
+    for (auto it = pool.pending.begin(); it != pool.pending.end();) {
+        if (it->deadline <= now) {
+            expired.emplace_back(std::move(*it));
+            it = pool.pending.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    for (auto &request : expired) {
+        request.handler(beast::error::timeout, {});
+    }
+}
+
+// Requests waiting for a connection time out too. Only armed while some
+// wait, so it does not keep the io_context running.
+//-------------------------------------
+void
+HttpsClient::armPendingTimer() {
+    auto deadline = HttpsRequest::Clock::time_point::max();
+    for (const auto &entry : mPools) {
+        for (const auto &request : entry.second.pending) {
+            deadline = std::min(deadline, request.deadline);
+        }
+    }
+    if (mStopped || deadline == mPendingExpiry) {
+        return;
+    }
+
+    mPendingExpiry = deadline;
+    if (deadline == HttpsRequest::Clock::time_point::max()) {
+        mPendingTimer.cancel();
+        return;
+    }
+
+    mPendingTimer.expires_at(deadline);
+    mPendingTimer.async_wait([self = shared_from_this()](beast::error_code ec) {
+        if (ec) {
+            return;
+        }
+        self->mPendingExpiry = HttpsRequest::Clock::time_point::max();
+        for (auto &entry : self->mPools) {
+            self->expirePending(entry.second);
+        }
+        self->armPendingTimer();
+    });
+}
+
+//-------------------------------------
+void
+HttpsClient::notifyReady(Pool &pool, bool ok) {
+    auto handlers = std::move(pool.onReady);
+    pool.onReady.clear();
+    for (auto &handler : handlers) {
+        handler(ok);
+    }
+}
+
+//-------------------------------------
+void
+HttpsClient::stop() {
+    net::post(mStrand, [self = shared_from_this()]() {
+        self->mStopped = true;
+        self->mResolver.cancel();
+        self->mPendingTimer.cancel();
+        for (auto &entry : self->mPools) {
+            auto &pool = entry.second;
+            for (auto connection : pool.connections) {
+                connection->close();
+            }
+            self->notifyReady(pool, false);
+            self->failPending(pool, net::error::operation_aborted);
+        }
+    });
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "net/httpsConnection.h"
+//--
+#include <boost/asio/strand.hpp>
+//--
+#include <deque>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// HTTPS client shared by every REST call. Keeps a pool of keep-alive
+// connections per host:port and pipelines requests on them, so only
+// the first request to a host pays for TCP + TLS.
+// Public functions are thread safe; handlers run on the client strand.
+//-------------------------------------
+class HttpsClient : public std::enable_shared_from_this<HttpsClient> {
+public:
+    using Headers       = std::vector<std::pair<std::string, std::string>>;
+    using ReadyHandler  = std::function<void(bool)>;
+
+    struct Options {
+        std::size_t                 maxConnectionsPerHost { 4 };
+        std::size_t                 maxPipelineDepth { 4 };
+        std::chrono::milliseconds   defaultTimeout { 10000 };
+    };
+
+public:
+    HttpsClient(net::io_context &ioc, ssl::context &ctx);
+    HttpsClient(net::io_context &ioc, ssl::context &ctx, const Options &options);
+
+    // Opens connections before they are needed. onReady(true) once
+    // one of them is usable, false if all failed.
+    void warmUp(const std::string &host, const std::string &port, std::size_t connections, ReadyHandler onReady = nullptr);
+
+    // A request without deadline gets Options::defaultTimeout, counted
+    // from here: time waiting for a connection is part of it
+    void async(const std::string &host, const std::string &port, HttpsRequest &&request);
+
+    void stop();
+
+    const Options &getOptions() const { return mOptions; }
+
+    // Serializes a keep-alive request once, to be sent many times
+    static std::string makeRequest(http::verb verb, std::string_view host, std::string_view target, std::string_view body, const Headers &headers = {});
+
+protected:
+    struct Pool {
+        std::string                                     host;
+        std::string                                     port;
+        tcp::resolver::results_type                     endpoints;
+        std::vector<std::shared_ptr<HttpsConnection>>   connections;    // Connecting ones too
+        std::deque<HttpsRequest>                        pending;
+        std::vector<ReadyHandler>                       onReady;
+        std::size_t                                     warm {};        // Connections kept open
+        bool                                            resolving {};
+    };
+
+protected:
+    Pool &getPool(const std::string &host, const std::string &port);
+
+    void resolve(Pool &pool);
+
+    void openConnection(Pool &pool);
+
+    void topUp(Pool &pool);
+
+    void onConnected(Pool &pool, const std::shared_ptr<HttpsConnection> &connection, beast::error_code ec);
+
+    void onClosed(Pool &pool, const std::shared_ptr<HttpsConnection> &connection, std::vector<HttpsRequest> &&retry);
+
+    void dispatch(Pool &pool);
+
+    void sendPending(Pool &pool);
+
+    void failPending(Pool &pool, beast::error_code ec);
+
+    void expirePending(Pool &pool);
+
+    void armPendingTimer();
+
+    void notifyReady(Pool &pool, bool ok);
+
+protected:
+    net::strand<net::io_context::executor_type> mStrand;
+    ssl::context                                &mCtx;
+    tcp::resolver                               mResolver;
+    net::steady_timer                           mPendingTimer;  // Earliest deadline in a pending queue
+    HttpsRequest::Clock::time_point             mPendingExpiry { HttpsRequest::Clock::time_point::max() };
+    Options                                     mOptions;
+    std::unordered_map<std::string, Pool>       mPools;     // host:port
+    bool                                        mStopped {};
+};
@@ -0,0 +1,308 @@
+#include "httpsConnection.h"
+#include "log/logger.h"
+//--
+#include <boost/asio/connect.hpp>
+#include <boost/asio/write.hpp>
+//--
+#include <algorithm>
+
+//-------------------------------------
+using namespace MindShake;
+
+//-------------------------------------
+constexpr const auto kConnectionTimeout = std::chrono::seconds(30);
+constexpr const auto kIdleReadBytes     = std::size_t(4 * 1024);
+
+//-------------------------------------
+HttpsConnection::HttpsConnection(const net::any_io_executor &executor, ssl::context &ctx)
+    : mStream(executor, ctx)
+    , mTimer(executor)
+{
+}
+
+//-------------------------------------
+void
+HttpsConnection::connect(const std::string &host, const tcp::resolver::results_type &endpoints, ConnectHandler handler) {
+    mHost           = host;
+    mConnectHandler = std::move(handler);
+
+    beast::get_lowest_layer(mStream).expires_after(kConnectionTimeout);
+    beast::get_lowest_layer(mStream).async_connect(endpoints, beast::bind_front_handler(&HttpsConnection::onConnect, shared_from_this()));
+}
+
+//-------------------------------------
+void
+HttpsConnection::onConnect(beast::error_code ec, tcp::endpoint ep) {
+    boost::ignore_unused(ep);
+    if (ec) {
+        return mConnectHandler(ec);
+    }
+
+    // Requests are small and latency bound
+    beast::get_lowest_layer(mStream).socket().set_option(tcp::no_delay(true), ec);
+
+    if (!SSL_set_tlsext_host_name(mStream.native_handle(), mHost.c_str())) {
+        ec = beast::error_code(static_cast<int>(::ERR_get_error()), net::error::get_ssl_category());
+        return mConnectHandler(ec);
+    }
+
+    beast::get_lowest_layer(mStream).expires_after(kConnectionTimeout);
+    mStream.async_handshake(ssl::stream_base::client, beast::bind_front_handler(&HttpsConnection::onHandshake, shared_from_this()));
+}
+
+//-------------------------------------
+void
+HttpsConnection::onHandshake(beast::error_code ec) {
+    if (!ec) {
+        // Deadlines are per request from now on
+        beast::get_lowest_layer(mStream).expires_never();
+        mOpen = true;
+        readNext();
+    }
+    mConnectHandler(ec);
+}
+
+//-------------------------------------
+void
+HttpsConnection::send(HttpsRequest &&request) {
+    if (request.idempotent == false) {
+        ++mUnsafe;
+    }
+    mRequests.emplace_back(std::move(request));
+    armTimer();
+    writeNext();
+}
+
+//-------------------------------------
+void
+HttpsConnection::writeNext() {
+    if (mOpen == false || mWriting) {
+        return;
+    }
+    expireUnsent();
+    if (mWritten == mRequests.size()) {
+        return;
+    }
+
+    mWriting = true;
+    net::async_write(mStream, mRequests[mWritten].bytes, beast::bind_front_handler(&HttpsConnection::onWrite, shared_from_this()));
+}
+
+//-------------------------------------
+void
+HttpsConnection::onWrite(beast::error_code ec, std::size_t bytesTransferred) {
+    boost::ignore_unused(bytesTransferred);
+    mWriting = false;
+    if (ec) {
+        return fail(ec);
+    }
+
+    mRequests[mWritten].written = HttpsRequest::Clock::now();
+    ++mWritten;
+    readNext();
+    writeNext();
+}
+
+// Responses arrive in request order, so only the head is read
+//-------------------------------------
+void
+HttpsConnection::readNext() {
+    if (mOpen == false || mReading) {
+        return;
+    }
+
+    mReading = true;
+    if (mWritten == 0) {
+        mStream.async_read_some(mBuffer.prepare(kIdleReadBytes), beast::bind_front_handler(&HttpsConnection::onIdleRead, shared_from_this()));
+        return;
+    }
+
+    const auto &body = mRequests.front().body;
+    mParser.emplace();
+    mParser->get().body() = http::span_body<char>::value_type(static_cast<char *>(body.data()), body.size());
+    http::async_read(mStream, mBuffer, *mParser, beast::bind_front_handler(&HttpsConnection::onRead, shared_from_this()));
+}
+
+//-------------------------------------
+void
+HttpsConnection::onRead(beast::error_code ec, std::size_t bytesTransferred) {
+    boost::ignore_unused(bytesTransferred);
+    mReading = false;
+    if (ec) {
+        // A reused connection closed before answering is a stale one: the
+        // head may go elsewhere if idempotent. Otherwise its response was bad.
+        return fail(ec, mReused == false || mParser->got_some());
+    }
+
+    auto request = std::move(mRequests.front());
+    mRequests.pop_front();
+    --mWritten;
+    if (request.idempotent == false) {
+        --mUnsafe;
+    }
+
+    // span_body advances its span over what it wrote
+    const auto &message = mParser->get();
+    HttpsResponse response;
+    response.status    = message.result_int();
+    response.bodySize  = request.body.size() - message.body().size();
+    response.keepAlive = message.keep_alive();
+    response.written   = request.written;
+    mParser.reset();
+
+    mReused = true;
+    if (response.keepAlive == false) {
+        mOpen = false;
+    }
+
+    request.handler({}, response);
+
+    if (response.keepAlive == false) {
+        return fail(net::error::connection_reset);
+    }
+
+    armTimer();
+    readNext();
+
+    if (mAvailableHandler) {
+        mAvailableHandler();
+    }
+}
+
+// Nothing was on the wire when this read started. Requests written
+// since then wait for it: its bytes, if any, start their response.
+//-------------------------------------
+void
+HttpsConnection::onIdleRead(beast::error_code ec, std::size_t bytesTransferred) {
+    mReading = false;
+    if (mOpen == false) {
+        return;
+    }
+    if (ec) {
+        // Closed by the server before answering anything: requests not sent,
+        // or idempotent, go to another connection
+        return fail(ec);
+    }
+
+    mBuffer.commit(bytesTransferred);
+    if (mWritten == 0) {
+        // Unsolicited, like a 408 sent before closing
+        return fail(net::error::connection_reset);
+    }
+    readNext();
+}
+
+//-------------------------------------
+void
+HttpsConnection::armTimer() {
+    if (mRequests.empty()) {
+        mTimer.cancel();
+        return;
+    }
+
+    auto deadline = std::min_element(mRequests.begin(), mRequests.end(), [](const auto &a, const auto &b) {
+        return a.deadline < b.deadline;
+    })->deadline;
+    if (deadline == HttpsRequest::Clock::time_point::max()) {
+        mTimer.cancel();
+        return;
+    }
+
+    mTimer.expires_at(deadline);
+    mTimer.async_wait(beast::bind_front_handler(&HttpsConnection::onTimer, shared_from_this()));
+}
+
+// A request on the wire, even partly, cannot be cancelled alone: the
+// connection goes. Those not written yet fail alone.
+//-------------------------------------
+void
+HttpsConnection::onTimer(beast::error_code ec) {
+    if (ec || mRequests.empty()) {
+        return;
+    }
+
+    const auto now = HttpsRequest::Clock::now();
+    for (std::size_t i = 0; i < mWritten + mWriting; ++i) {
+        if (mRequests[i].deadline <= now) {
+            return fail(beast::error::timeout);
+        }
+    }
+    expireUnsent();
+    armTimer();
+}
+
+//-------------------------------------
+void
+HttpsConnection::expireUnsent() {
+    const auto now = HttpsRequest::Clock::now();
+    std::vector<HttpsRequest> expired;
+    for (auto it = mRequests.begin() + mWritten + mWriting; it != mRequests.end();) {
+        if (it->deadline <= now) {
+            if (it->idempotent == false) {
+                --mUnsafe;
+            }
+            expired.emplace_back(std::move(*it));
+            it = mRequests.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    for (auto &request : expired) {
+        request.handler(beast::error::timeout, {});
+    }
+}
+
+// Expired requests (and the head one if headFailed) get ec. The rest
+// go to the close handler if they never reached the server or can be
+// sent again.
+//-------------------------------------
+void
+HttpsConnection::fail(beast::error_code ec, bool headFailed) {
+    if (ec != net::error::connection_reset) {
+        Logger::debug("HttpsConnection {}: {}", mHost, ec.message());
+    }
+    close();
+
+    const auto now = HttpsRequest::Clock::now();
+    std::vector<HttpsRequest> retry;
+    std::vector<HttpsRequest> failed;
+    for (std::size_t i = 0; i < mRequests.size(); ++i) {
+        auto &request = mRequests[i];
+        if ((i != 0 || headFailed == false) && request.deadline > now && (i >= mWritten || request.idempotent)) {
+            retry.emplace_back(std::move(request));
+        }
+        else {
+            failed.emplace_back(std::move(request));
+        }
+    }
+    mRequests.clear();
+    mWritten = 0;
+    mUnsafe  = 0;
+
+    for (auto &request : failed) {
+        request.handler(ec == net::error::connection_reset ? net::error::connection_aborted : ec, {});
+    }
+
+    mAvailableHandler = nullptr;
+    if (mCloseHandler) {
+        std::exchange(mCloseHandler, nullptr)(std::move(retry));
+    }
+    else {
+        for (auto &request : retry) {
+            request.handler(net::error::connection_aborted, {});
+        }
+    }
+}
+
+//-------------------------------------
+void
+HttpsConnection::close() {
+    mOpen = false;
+    mTimer.cancel();
+
+    beast::error_code ec;
+    beast::get_lowest_layer(mStream).socket().shutdown(tcp::socket::shutdown_both, ec);
+    beast::get_lowest_layer(mStream).close();
+}
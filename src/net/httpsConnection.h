@@ -0,0 +1,121 @@
+#pragma once
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/asio/steady_timer.hpp>
+//--
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+//-------------------------------------
+namespace beast     = boost::beast;         // from <boost/beast.hpp>
+namespace http      = beast::http;          // from <boost/beast/http.hpp>
+namespace net       = boost::asio;          // from <boost/asio.hpp>
+namespace ssl       = boost::asio::ssl;     // from <boost/asio/ssl.hpp>
+using tcp           = boost::asio::ip::tcp; // from <boost/asio/ip/tcp.hpp>
+
+//-------------------------------------
+struct HttpsResponse {
+    unsigned                                status {};
+    std::size_t                             bodySize {};    // Bytes written to HttpsRequest::body
+    bool                                    keepAlive {};
+    std::chrono::steady_clock::time_point   written {};     // When the last request byte left
+};
+
+// An already serialized request. Both buffers belong to the caller
+// and must stay alive until the handler runs.
+//-------------------------------------
+struct HttpsRequest {
+    using Clock           = std::chrono::steady_clock;
+    using ResponseHandler = std::function<void(beast::error_code, const HttpsResponse &)>;
+
+    net::const_buffer   bytes;
+    net::mutable_buffer body;               // Too small: http::error::buffer_overflow
+    Clock::time_point   deadline { Clock::time_point::max() };
+    bool                idempotent {};      // May be sent again on another connection
+    ResponseHandler     handler;
+    Clock::time_point   written {};         // Set by the connection
+};
+
+// One keep-alive HTTPS connection: connect + TLS once, then pipeline
+// requests on it. Responses come back in order; the connection closes
+// itself on errors, on `Connection: close` and when a deadline expires.
+// While idle a read stays armed, so a close from the server is seen
+// before the next request goes out on a dead connection.
+// Not thread safe: use it from the executor it was created with.
+//-------------------------------------
+class HttpsConnection : public std::enable_shared_from_this<HttpsConnection> {
+public:
+    using ConnectHandler    = std::function<void(beast::error_code)>;
+    // Gets the requests that can still be sent elsewhere
+    using CloseHandler      = std::function<void(std::vector<HttpsRequest> &&retry)>;
+    // Runs after each response, once the connection can take another request
+    using AvailableHandler  = std::function<void()>;
+
+public:
+    HttpsConnection(const net::any_io_executor &executor, ssl::context &ctx);
+
+    void connect(const std::string &host, const tcp::resolver::results_type &endpoints, ConnectHandler handler);
+
+    void setCloseHandler(CloseHandler handler)          { mCloseHandler = std::move(handler); }
+    void setAvailableHandler(AvailableHandler handler)  { mAvailableHandler = std::move(handler); }
+
+    void send(HttpsRequest &&request);
+
+    void close();
+
+    bool        isOpen() const      { return mOpen; }
+    std::size_t inFlight() const    { return mRequests.size(); }
+
+    // RFC 7230 6.3.2: only idempotent requests are pipelined, and never
+    // behind one that is not
+    bool        canPipeline(const HttpsRequest &request) const { return mRequests.empty() || (request.idempotent && mUnsafe == 0); }
+
+protected:
+    void onConnect(beast::error_code ec, tcp::endpoint ep);
+
+    void onHandshake(beast::error_code ec);
+
+    void writeNext();
+
+    void onWrite(beast::error_code ec, std::size_t bytesTransferred);
+
+    void readNext();
+
+    void onRead(beast::error_code ec, std::size_t bytesTransferred);
+
+    void onIdleRead(beast::error_code ec, std::size_t bytesTransferred);
+
+    void armTimer();
+
+    void onTimer(beast::error_code ec);
+
+    void expireUnsent();
+
+    void fail(beast::error_code ec, bool headFailed = false);
+
+protected:
+    using Parser = http::response_parser<http::span_body<char>>;
+
+    ssl::stream<beast::tcp_stream>  mStream;
+    net::steady_timer               mTimer;
+    beast::flat_buffer              mBuffer;
+    std::optional<Parser>           mParser;
+    std::deque<HttpsRequest>        mRequests;  // The first mWritten ones are on the wire
+    std::size_t                     mWritten {};
+    std::size_t                     mUnsafe {};     // Non idempotent requests in flight
+    std::string                     mHost;
+    ConnectHandler                  mConnectHandler;
+    CloseHandler                    mCloseHandler;
+    AvailableHandler                mAvailableHandler;
+    bool                            mOpen {};
+    bool                            mWriting {};
+    bool                            mReading {};
+    bool                            mReused {};     // Has answered a request
+};
@@ -0,0 +1,177 @@
+#include "orderClient.h"
+#include "log/logger.h"
+//--
+#include <boost/beast/version.hpp>
+//--
+#include <cmath>
+
+//-------------------------------------
+using namespace MindShake;
+
+//-------------------------------------
+static std::size_t
+replaceField(std::string &body, std::string_view name, uint8_t width) {
+    auto pos = body.find(name);
+    if (pos == std::string::npos) {
+        return std::string::npos;
+    }
+    body.replace(pos, name.size(), width, ' ');
+    return pos;
+}
+
+//-------------------------------------
+OrderTemplate::OrderTemplate(std::string_view host, std::string_view target, std::string_view bodyPattern, const Headers &headers) {
+    constexpr std::string_view kStakeName = "{stake}";
+
+    std::string body(bodyPattern);
+    auto price = replaceField(body, "{price}", kPriceWidth);
+    auto stake = replaceField(body, kStakeName, kStakeWidth);
+    if (price != std::string::npos && stake != std::string::npos && stake < price) {
+        price += kStakeWidth - kStakeName.size();
+    }
+
+    mBytes.reserve(512 + body.size());
+    mBytes += "POST ";
+    mBytes += target;
+    mBytes += " HTTP/1.1\r\nHost: ";
+    mBytes += host;
+    mBytes += "\r\nUser-Agent: " BOOST_BEAST_VERSION_STRING "\r\nContent-Type: application/json\r\nConnection: keep-alive\r\n";
+    for (const auto &header : headers) {
+        mBytes += header.first;
+        mBytes += ": ";
+        mBytes += header.second;
+        mBytes += "\r\n";
+    }
+    mBytes += "Content-Length: ";
+    mBytes += std::to_string(body.size());
+    mBytes += "\r\n\r\n";
+
+    const auto bodyOffset = mBytes.size();
+    mBytes += body;
+
+    if (price != std::string::npos && stake != std::string::npos) {
+        mPrice = { bodyOffset + price, kPriceWidth, kPriceDecimals };
+        mStake = { bodyOffset + stake, kStakeWidth, kStakeDecimals };
+    }
+    else {
+        Logger::error("OrderTemplate: body needs both {{price}} and {{stake}}");
+    }
+}
+
+//-------------------------------------
+bool
+OrderTemplate::patch(std::string &request, const Field &field, double value) {
+    if (!(value >= 0.0) || field.offset + field.width > request.size()) {
+        return false;
+    }
+
+    uint64_t scale = 1;
+    for (uint8_t i = 0; i < field.decimals; ++i) {
+        scale *= 10;
+    }
+    auto units = static_cast<uint64_t>(std::llround(value * double(scale)));
+
+    // Written backwards: decimals, point, integer part, padding
+    char *begin = request.data() + field.offset;
+    char *out   = begin + field.width;
+    for (uint8_t i = 0; i < field.decimals; ++i) {
+        *--out = char('0' + units % 10);
+        units /= 10;
+    }
+    if (field.decimals != 0) {
+        *--out = '.';
+    }
+    do {
+        if (out == begin) {
+            return false;
+        }
+        *--out = char('0' + units % 10);
+        units /= 10;
+    } while (units != 0);
+
+    while (out != begin) {
+        *--out = ' ';
+    }
+    return true;
+}
+
+//-------------------------------------
+OrderClient::OrderClient(std::shared_ptr<HttpsClient> https, std::string host, std::string port)
+    : mHttps(std::move(https))
+    , mHost(std::move(host))
+    , mPort(std::move(port))
+{
+}
+
+//-------------------------------------
+void
+OrderClient::start(std::size_t connections, ReadyHandler onReady) {
+    mHttps->warmUp(mHost, mPort, connections, std::move(onReady));
+}
+
+//-------------------------------------
+OrderClient::OrderPtr
+OrderClient::acquire() {
+    {
+        std::lock_guard guard(mMutex);
+        if (mFree.empty() == false) {
+            auto order = std::move(mFree.back());
+            mFree.pop_back();
+            return order;
+        }
+    }
+    return std::make_shared<Order>();
+}
+
+//-------------------------------------
+void
+OrderClient::release(OrderPtr &&order) {
+    order->handler = nullptr;
+
+    std::lock_guard guard(mMutex);
+    mFree.emplace_back(std::move(order));
+}
+
+//-------------------------------------
+void
+OrderClient::place(const TemplatePtr &tmpl, double price, double stake, OrderHandler handler) {
+    auto order = acquire();
+    order->handler = std::move(handler);
+
+    // Same size as the template, so the buffer is reused
+    if (tmpl == nullptr || tmpl->isValid() == false) {
+        return onResponse(order, net::error::invalid_argument, {});
+    }
+    order->request.assign(tmpl->bytes());
+    if (OrderTemplate::patch(order->request, tmpl->price(), price) == false ||
+        OrderTemplate::patch(order->request, tmpl->stake(), stake) == false) {
+        return onResponse(order, net::error::invalid_argument, {});
+    }
+
+    HttpsRequest request;
+    request.bytes   = net::buffer(order->request);
+    request.body    = net::buffer(order->response);
+    request.handler = [self = shared_from_this(), order](beast::error_code ec, const HttpsResponse &res) {
+        self->onResponse(order, ec, res);
+    };
+    mHttps->async(mHost, mPort, std::move(request));
+}
+
+//-------------------------------------
+void
+OrderClient::onResponse(const OrderPtr &order, beast::error_code ec, const HttpsResponse &res) {
+    // Queueing and connection waits are not the exchange's doing
+    OrderResult result;
+    result.ec = ec;
+    if (!ec) {
+        result.latency = LatencyStats::Clock::now() - res.written;
+        result.status  = res.status;
+        result.body    = std::string_view(order->response.data(), res.bodySize);
+        mLatency.add(result.latency);
+    }
+
+    if (order->handler) {
+        order->handler(result);
+    }
+    release(OrderPtr(order));
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "net/httpsClient.h"
+#include "utils/latencyStats.h"
+//--
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// A fully serialized HTTP request whose numeric fields have a fixed
+// width, so they can be rewritten in place without touching the rest
+// (JSON allows the padding spaces). The body pattern names them as
+// {price} and {stake}, e.g.:
+//   {"betslip_id": "...", "price": {price}, "stake": ["EUR", {stake}]}
+//-------------------------------------
+class OrderTemplate {
+public:
+    using Headers = std::vector<std::pair<std::string, std::string>>;
+
+    struct Field {
+        std::size_t offset {};
+        uint8_t     width {};
+        uint8_t     decimals {};
+    };
+
+    static constexpr uint8_t kPriceWidth    = 10;
+    static constexpr uint8_t kPriceDecimals = 3;
+    static constexpr uint8_t kStakeWidth    = 14;
+    static constexpr uint8_t kStakeDecimals = 2;
+
+public:
+    OrderTemplate(std::string_view host, std::string_view target, std::string_view bodyPattern, const Headers &headers = {});
+
+    const std::string & bytes() const   { return mBytes; }
+    const Field &       price() const   { return mPrice; }
+    const Field &       stake() const   { return mStake; }
+    bool                isValid() const { return mPrice.width != 0 && mStake.width != 0; }
+
+    // Writes value right aligned in the field of a copy of bytes().
+    // False if it is negative or does not fit.
+    static bool patch(std::string &request, const Field &field, double value);
+
+protected:
+    std::string mBytes;
+    Field       mPrice;
+    Field       mStake;
+};
+
+//-------------------------------------
+struct OrderResult {
+    beast::error_code           ec;
+    unsigned                    status {};
+    std::string_view            body;       // Valid inside the handler only
+    std::chrono::nanoseconds    latency {}; // Request written -> response read
+};
+
+// Sends OrderTemplate requests over the warm connections of a shared
+// HttpsClient. Request and response buffers are recycled.
+//-------------------------------------
+class OrderClient : public std::enable_shared_from_this<OrderClient> {
+public:
+    using OrderHandler  = std::function<void(const OrderResult &)>;
+    using ReadyHandler  = HttpsClient::ReadyHandler;
+    using TemplatePtr   = std::shared_ptr<const OrderTemplate>;
+
+    static constexpr std::size_t kMaxResponse = 4096;
+
+public:
+    OrderClient(std::shared_ptr<HttpsClient> https, std::string host, std::string port);
+
+    // Keeps `connections` connections to the betting host open
+    void start(std::size_t connections, ReadyHandler onReady);
+
+    // Thread safe. Orders are not idempotent: a failed one is reported,
+    // never sent again. Invalid values are reported from inside place().
+    void place(const TemplatePtr &tmpl, double price, double stake, OrderHandler handler);
+
+    // Valid once the io_context has stopped
+    const MindShake::LatencyStats &getLatencyStats() const { return mLatency; }
+
+protected:
+    struct Order {
+        std::string                                 request;    // Patched copy of the template
+        std::vector<char>                           response = std::vector<char>(kMaxResponse);
+        OrderHandler                                handler;
+    };
+    using OrderPtr = std::shared_ptr<Order>;
+
+protected:
+    OrderPtr acquire();
+
+    void release(OrderPtr &&order);
+
+    void onResponse(const OrderPtr &order, beast::error_code ec, const HttpsResponse &res);
+
+protected:
+    std::shared_ptr<HttpsClient>    mHttps;
+    std::string                     mHost;
+    std::string                     mPort;
+    std::mutex                      mMutex;
+    std::vector<OrderPtr>           mFree;
+    MindShake::LatencyStats         mLatency;
+};
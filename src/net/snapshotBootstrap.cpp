@@ -0,0 +1,156 @@
+#include "snapshotBootstrap.h"
+#include "log/logger.h"
+//--
+#include <boost/asio/post.hpp>
+
+//-------------------------------------
+using namespace MindShake;
+
+//-------------------------------------
+SnapshotBootstrap::SnapshotBootstrap(net::io_context &ioc, std::shared_ptr<HttpsClient> https, std::string host, std::string port)
+    : SnapshotBootstrap(ioc, std::move(https), std::move(host), std::move(port), Options())
+{
+}
+
+//-------------------------------------
+SnapshotBootstrap::SnapshotBootstrap(net::io_context &ioc, std::shared_ptr<HttpsClient> https, std::string host, std::string port, const Options &options)
+    : mStrand(net::make_strand(ioc))
+    , mHttps(std::move(https))
+    , mHost(std::move(host))
+    , mPort(std::move(port))
+    , mOptions(options)
+{
+}
+
+//-------------------------------------
+void
+SnapshotBootstrap::run(const std::string &token, SnapshotHandler onSnapshot, FrameHandler onReplay, DoneHandler onDone) {
+    {
+        std::lock_guard guard(mMutex);
+        mHolding = true;
+    }
+
+    mOnSnapshot = std::move(onSnapshot);
+    mOnReplay   = std::move(onReplay);
+    mOnDone     = std::move(onDone);
+    mStarted    = Clock::now();
+
+    // Parts are created before any request goes out: handlers index them
+    const HttpsClient::Headers headers = { { mOptions.tokenHeader, token } };
+    mParts.reserve(mTargets.size());
+    for (const auto &target : mTargets) {
+        auto part = std::make_unique<Part>();
+        part->target  = target;
+        part->request = HttpsClient::makeRequest(http::verb::get, mHost, target, {}, headers);
+        part->body.resize(mOptions.maxBodyBytes);
+        mParts.emplace_back(std::move(part));
+    }
+
+    mHttps->warmUp(mHost, mPort, mParts.size());
+
+    const auto deadline = Clock::now() + mOptions.timeout;
+    for (std::size_t i = 0; i < mParts.size(); ++i) {
+        HttpsRequest request;
+        request.bytes      = net::buffer(mParts[i]->request);
+        request.body       = net::buffer(mParts[i]->body);
+        request.deadline   = deadline;
+        request.idempotent = true;
+        request.handler    = [self = shared_from_this(), i](beast::error_code ec, const HttpsResponse &res) {
+            self->onResponse(i, ec, res);
+        };
+        mHttps->async(mHost, mPort, std::move(request));
+    }
+
+    if (mParts.empty()) {
+        net::post(mStrand, [self = shared_from_this()]() { self->deliver(); });
+    }
+}
+
+// Runs on the client strand
+//-------------------------------------
+void
+SnapshotBootstrap::onResponse(std::size_t index, beast::error_code ec, const HttpsResponse &res) {
+    auto &part = *mParts[index];
+    if (ec || res.status != 200) {
+        Logger::error("Snapshot {}: {}", part.target, ec ? ec.message() : std::to_string(res.status));
+        part.body.clear();
+    }
+    else {
+        part.body.resize(res.bodySize);
+    }
+    net::post(mStrand, [self = shared_from_this(), index]() { self->onReceived(index); });
+}
+
+//-------------------------------------
+void
+SnapshotBootstrap::onReceived(std::size_t index) {
+    auto &part = *mParts[index];
+    part.ready = true;
+    if (part.body.empty()) {
+        mOk = false;
+    }
+    deliver();
+}
+
+// Parts are handed over in target order, whatever order they finish in
+//-------------------------------------
+void
+SnapshotBootstrap::deliver() {
+    while (mNext < mParts.size() && mParts[mNext]->ready) {
+        auto &part = *mParts[mNext++];
+        if (part.body.empty() == false && mOnSnapshot) {
+            mOnSnapshot(part.target, std::string_view(part.body.data(), part.body.size()));
+        }
+        part.body = {};
+    }
+
+    if (mNext < mParts.size()) {
+        return;
+    }
+
+    mElapsed = Clock::now() - mStarted;
+    Logger::info("Snapshot: {} parts in {} ms", mParts.size(), std::chrono::duration_cast<std::chrono::milliseconds>(mElapsed).count());
+    replay();
+    if (mOnDone) {
+        mOnDone(mOk);
+    }
+}
+
+// Frames held while replaying are picked up by the next round, so the
+// stream order is kept until holding stops
+//-------------------------------------
+void
+SnapshotBootstrap::replay() {
+    std::size_t replayed = 0;
+    for (;;) {
+        std::vector<std::string> held;
+        {
+            std::lock_guard guard(mMutex);
+            if (mHeld.empty()) {
+                mHolding = false;
+                break;
+            }
+            held.swap(mHeld);
+        }
+
+        for (const auto &frame : held) {
+            ++replayed;
+            if (mOnReplay) {
+                mOnReplay(frame);
+            }
+        }
+    }
+    Logger::debug("Snapshot: {} stream frames replayed", replayed);
+}
+
+//-------------------------------------
+bool
+SnapshotBootstrap::admitStreamFrame(std::string_view frame) {
+    std::lock_guard guard(mMutex);
+    if (mHolding == false) {
+        return true;
+    }
+
+    mHeld.emplace_back(frame);
+    return false;
+}
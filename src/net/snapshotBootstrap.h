@@ -0,0 +1,90 @@
+#pragma once
+
+#include "net/httpsClient.h"
+//--
+#include <boost/asio/strand.hpp>
+//--
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Optional start-up path: the initial state is fetched with parallel
+// REST requests over pooled connections while the stream is already
+// attached. Parts are shaped like stream frames and handed over raw, in
+// target order, for the caller to decode (e.g. on a ParallelDecoder).
+//
+// Reconciliation: stream frames arriving meanwhile are held back, then
+// replayed in arrival order once every part was handed over. Which of
+// their records the snapshot already covers is up to the replay handler,
+// which can check each one against the state the parts built.
+//-------------------------------------
+class SnapshotBootstrap : public std::enable_shared_from_this<SnapshotBootstrap> {
+public:
+    using Clock           = std::chrono::steady_clock;
+    using SnapshotHandler = std::function<void(const std::string &target, std::string_view body)>;
+    using FrameHandler    = std::function<void(std::string_view frame)>;
+    using DoneHandler     = std::function<void(bool ok)>;
+
+    struct Options {
+        std::size_t                 maxBodyBytes { 8 * 1024 * 1024 };
+        std::chrono::milliseconds   timeout { 30000 };
+        std::string                 tokenHeader { "Session" };
+    };
+
+public:
+    SnapshotBootstrap(net::io_context &ioc, std::shared_ptr<HttpsClient> https, std::string host, std::string port);
+    SnapshotBootstrap(net::io_context &ioc, std::shared_ptr<HttpsClient> https, std::string host, std::string port, const Options &options);
+
+    // Before run()
+    void addTarget(std::string target) { mTargets.emplace_back(std::move(target)); }
+    bool empty() const                 { return mTargets.empty(); }
+
+    // Handlers run on the bootstrap strand. Frames come to onReplay once
+    // the last part went to onSnapshot, and onDone follows them.
+    void run(const std::string &token, SnapshotHandler onSnapshot, FrameHandler onReplay, DoneHandler onDone);
+
+    // Thread safe. False when the frame was held back for later replay.
+    bool admitStreamFrame(std::string_view frame);
+
+    // Time from run() until the last part was delivered
+    std::chrono::nanoseconds getElapsed() const { return mElapsed; }
+
+protected:
+    struct Part {
+        std::string         target;
+        std::string         request;
+        std::vector<char>   body;       // Empty if the request failed
+        bool                ready {};
+    };
+
+protected:
+    void onResponse(std::size_t index, beast::error_code ec, const HttpsResponse &res);
+
+    void onReceived(std::size_t index);
+
+    void deliver();
+
+    void replay();
+
+protected:
+    net::strand<net::io_context::executor_type> mStrand;
+    std::shared_ptr<HttpsClient>                mHttps;
+    std::string                                 mHost;
+    std::string                                 mPort;
+    Options                                     mOptions;
+    std::vector<std::string>                    mTargets;
+    std::vector<std::unique_ptr<Part>>          mParts;
+    std::size_t                                 mNext {};       // Next part to deliver
+    bool                                        mOk { true };
+    Clock::time_point                           mStarted;
+    std::chrono::nanoseconds                    mElapsed {};
+    SnapshotHandler                             mOnSnapshot;
+    FrameHandler                                mOnReplay;
+    DoneHandler                                 mOnDone;
+
+    std::mutex                                  mMutex;         // Held frames come from the stream strand
+    bool                                        mHolding {};
+    std::vector<std::string>                    mHeld;
+};
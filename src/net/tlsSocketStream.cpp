@@ -0,0 +1,158 @@
+#include "tlsSocketStream.h"
+#include "log/logger.h"
+//--
+#include <openssl/err.h>
+//--
+#include <cerrno>
+#include <stdexcept>
+
+//-------------------------------------
+using namespace MindShake;
+
+//-------------------------------------
+void
+TlsSocketStream::init(ssl::context &ctx) {
+    mSSL = SSL_new(ctx.native_handle());
+    if (mSSL == nullptr) {
+        throw std::runtime_error("TlsSocketStream: SSL_new failed");
+    }
+
+    // Same modes asio's ssl::stream sets
+    SSL_set_mode(mSSL, SSL_MODE_ENABLE_PARTIAL_WRITE);
+    SSL_set_mode(mSSL, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+    SSL_set_mode(mSSL, SSL_MODE_RELEASE_BUFFERS);
+}
+
+//-------------------------------------
+TlsSocketStream::~TlsSocketStream() {
+    if (mSSL != nullptr) {
+        SSL_free(mSSL);
+    }
+}
+
+//-------------------------------------
+bool
+TlsSocketStream::setKernelTLS(bool enable) {
+#if defined(MOLLY_HAS_KTLS)
+    if (enable) {
+        // The context picks the TLS version. Before 3.2 OpenSSL only
+        // offloads TLS 1.3 on the send side, so those get no kTLS reads.
+        SSL_set_options(mSSL, SSL_OP_ENABLE_KTLS);
+    }
+    else {
+        SSL_clear_options(mSSL, SSL_OP_ENABLE_KTLS);
+    }
+    return true;
+#else
+    if (enable) {
+        Logger::warning("kTLS: not available in this build (needs Linux and OpenSSL 3 with ktls)");
+    }
+    return enable == false;
+#endif
+}
+
+//-------------------------------------
+bool
+TlsSocketStream::isKernelTLSRecv() const {
+#if defined(MOLLY_HAS_KTLS)
+    return mAttached && BIO_get_ktls_recv(SSL_get_rbio(mSSL)) != 0;
+#else
+    return false;
+#endif
+}
+
+//-------------------------------------
+bool
+TlsSocketStream::isKernelTLSSend() const {
+#if defined(MOLLY_HAS_KTLS)
+    return mAttached && BIO_get_ktls_send(SSL_get_wbio(mSSL)) != 0;
+#else
+    return false;
+#endif
+}
+
+//-------------------------------------
+void
+TlsSocketStream::expires_after(std::chrono::steady_clock::duration after) {
+    mDeadline = std::chrono::steady_clock::now() + after;
+}
+
+//-------------------------------------
+void
+TlsSocketStream::expires_never() {
+    mDeadline = std::chrono::steady_clock::time_point::max();
+    mTimer.cancel();
+}
+
+//-------------------------------------
+void
+TlsSocketStream::armTimer() {
+    if (mDeadline == std::chrono::steady_clock::time_point::max()) {
+        return;
+    }
+
+    mTimedOut = false;
+    mTimer.expires_at(mDeadline);
+    mTimer.async_wait([this](beast::error_code ec) {
+        if (ec) {
+            return;
+        }
+        mTimedOut = true;
+        beast::error_code ignored;
+        mStream.socket().cancel(ignored);
+    });
+}
+
+//-------------------------------------
+void
+TlsSocketStream::disarmTimer() {
+    if (mDeadline != std::chrono::steady_clock::time_point::max()) {
+        mTimer.cancel();
+    }
+}
+
+// The socket only exists once connected, so bind it on first use
+//-------------------------------------
+bool
+TlsSocketStream::attachSocket(beast::error_code &ec) {
+    auto &socket = mStream.socket();
+
+    // OpenSSL calls recv/send directly, they must not block the I/O thread
+    socket.native_non_blocking(true, ec);
+    if (ec) {
+        return false;
+    }
+
+    if (SSL_set_fd(mSSL, static_cast<int>(socket.native_handle())) != 1) {
+        ec = beast::error_code(static_cast<int>(::ERR_get_error()), net::error::get_ssl_category());
+        return false;
+    }
+
+    mAttached = true;
+    return true;
+}
+
+//-------------------------------------
+beast::error_code
+TlsSocketStream::toErrorCode(int sslError) {
+    switch (sslError) {
+        case SSL_ERROR_ZERO_RETURN:
+            return net::error::eof;
+
+        case SSL_ERROR_SYSCALL:
+            if (errno != 0) {
+                return beast::error_code(errno, net::error::get_system_category());
+            }
+            return ssl::error::stream_truncated;
+
+        default: {
+            const auto error = ::ERR_get_error();
+        #if defined(SSL_R_UNEXPECTED_EOF_WHILE_READING)
+            if (ERR_GET_REASON(error) == SSL_R_UNEXPECTED_EOF_WHILE_READING) {
+                return ssl::error::stream_truncated;
+            }
+        #endif
+            return beast::error_code(static_cast<int>(error), net::error::get_ssl_category());
+        }
+    }
+}
@@ -0,0 +1,317 @@
+#pragma once
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/websocket.hpp>
+#include <boost/asio/ssl.hpp>
+//--
+#include <openssl/ssl.h>
+//--
+#include <chrono>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+
+// OpenSSL 3 can hand the record layer to the kernel, but only when
+// it owns the socket (socket BIO). asio's ssl::stream uses a memory
+// BIO pair, which is why this stream exists at all.
+#if defined(__linux__) && OPENSSL_VERSION_NUMBER >= 0x30000000L && !defined(OPENSSL_NO_KTLS)
+    #define MOLLY_HAS_KTLS
+#endif
+
+//-------------------------------------
+namespace beast     = boost::beast;         // from <boost/beast.hpp>
+namespace net       = boost::asio;          // from <boost/asio.hpp>
+namespace ssl       = boost::asio::ssl;     // from <boost/asio/ssl.hpp>
+using tcp           = boost::asio::ip::tcp; // from <boost/asio/ip/tcp.hpp>
+
+// TLS client stream where OpenSSL reads and writes the socket itself.
+// Models AsyncStream so it can sit below websocket::stream.
+//-------------------------------------
+class TlsSocketStream {
+public:
+    using next_layer_type = beast::tcp_stream;
+    using executor_type   = next_layer_type::executor_type;
+
+    template <typename Executor>
+    TlsSocketStream(Executor &&ex, ssl::context &ctx) : mStream(std::forward<Executor>(ex)), mTimer(mStream.get_executor()) {
+        init(ctx);
+    }
+    ~TlsSocketStream();
+
+    TlsSocketStream(const TlsSocketStream &) = delete;
+    TlsSocketStream &operator=(const TlsSocketStream &) = delete;
+
+    executor_type       get_executor() noexcept { return mStream.get_executor(); }
+    next_layer_type &   next_layer()            { return mStream; }
+    SSL *               native_handle()         { return mSSL; }
+
+    // Must be called before the handshake. Returns false when this
+    // build cannot offload TLS to the kernel.
+    bool setKernelTLS(bool enable);
+
+    // OpenSSL waits on the socket itself, out of reach of tcp_stream's
+    // expires_after, so the handshake gets its own deadline. Operations
+    // past it fail with beast::error::timeout. Meant for the handshake,
+    // when a single operation runs; websocket::stream has its own timeouts.
+    void expires_after(std::chrono::steady_clock::duration after);
+    void expires_never();
+
+    // Valid after the handshake: did OpenSSL hand the keys to the kernel?
+    bool isKernelTLSRecv() const;
+    bool isKernelTLSSend() const;
+
+    //---------------------------------
+    template <typename CompletionToken>
+    auto async_handshake(ssl::stream_base::handshake_type type, CompletionToken &&token);
+
+    template <typename MutableBufferSequence, typename CompletionToken>
+    auto async_read_some(const MutableBufferSequence &buffers, CompletionToken &&token);
+
+    template <typename ConstBufferSequence, typename CompletionToken>
+    auto async_write_some(const ConstBufferSequence &buffers, CompletionToken &&token);
+
+    template <typename CompletionToken>
+    auto async_shutdown(CompletionToken &&token);
+
+protected:
+    void init(ssl::context &ctx);
+    bool attachSocket(beast::error_code &ec);
+
+    // Cancels the socket waits when the deadline passes
+    void armTimer();
+    void disarmTimer();
+
+    template <typename Action> friend class TlsSocketOp;
+
+    // Maps the result of an SSL_* call to an asio error code
+    static beast::error_code toErrorCode(int sslError);
+
+protected:
+    static constexpr std::size_t kMaxRecord = 16 * 1024;
+
+    beast::tcp_stream       mStream;
+    SSL                     *mSSL {};
+    bool                    mAttached {};
+    std::unique_ptr<char[]> mWriteScratch;  // Only one write is ever in flight
+    net::steady_timer       mTimer;
+    std::chrono::steady_clock::time_point   mDeadline { std::chrono::steady_clock::time_point::max() };
+    bool                    mTimedOut {};
+};
+
+// Runs one SSL_* call until it stops asking for socket readiness.
+// Action: int operator()(SSL *, std::size_t &bytes) returning SSL_get_error.
+//-------------------------------------
+template <typename Action>
+class TlsSocketOp {
+public:
+    TlsSocketOp(TlsSocketStream &stream, Action action) : mStream(stream), mAction(std::move(action)) { }
+
+    template <typename Self>
+    void operator()(Self &self, beast::error_code ec = {}) {
+        if (mPosted) {
+            return finish(self, mEc, mBytes);
+        }
+        if (mSuspended) {
+            mStream.disarmTimer();
+            if (ec == net::error::operation_aborted && mStream.mTimedOut) {
+                ec = beast::error::timeout;
+            }
+        }
+        if (ec) {
+            return finish(self, ec, 0);
+        }
+
+        if (mStream.mAttached == false && mStream.attachSocket(ec) == false) {
+            return finish(self, ec, 0);
+        }
+
+        std::size_t bytes = 0;
+        switch (const int result = mAction(mStream.mSSL, bytes)) {
+            case SSL_ERROR_NONE:
+                break;
+
+            case SSL_ERROR_WANT_READ:
+                mSuspended = true;
+                mStream.armTimer();
+                return mStream.mStream.socket().async_wait(tcp::socket::wait_read, std::move(self));
+
+            case SSL_ERROR_WANT_WRITE:
+                mSuspended = true;
+                mStream.armTimer();
+                return mStream.mStream.socket().async_wait(tcp::socket::wait_write, std::move(self));
+
+            default:
+                ec = TlsSocketStream::toErrorCode(result);
+                break;
+        }
+
+        // Never complete from inside the initiating function
+        if (mSuspended == false) {
+            mPosted = true;
+            mEc     = ec;
+            mBytes  = bytes;
+            return net::post(mStream.get_executor(), std::move(self));
+        }
+
+        finish(self, ec, bytes);
+    }
+
+protected:
+    template <typename Self>
+    void finish(Self &self, beast::error_code ec, std::size_t bytes) {
+        if constexpr (Action::kTransfersBytes)
+            self.complete(ec, bytes);
+        else
+            self.complete(ec);
+    }
+
+protected:
+    TlsSocketStream     &mStream;
+    Action              mAction;
+    beast::error_code   mEc;
+    std::size_t         mBytes {};
+    bool                mSuspended {};
+    bool                mPosted {};
+};
+
+//-------------------------------------
+namespace TlsSocketActions {
+
+    //---------------------------------
+    struct Handshake {
+        static constexpr bool kTransfersBytes = false;
+
+        int operator()(SSL *ssl, std::size_t &) const {
+            ERR_clear_error();
+            const int ret = SSL_connect(ssl);
+            return ret == 1 ? SSL_ERROR_NONE : SSL_get_error(ssl, ret);
+        }
+    };
+
+    //---------------------------------
+    struct Read {
+        static constexpr bool kTransfersBytes = true;
+
+        net::mutable_buffer buffer;
+
+        int operator()(SSL *ssl, std::size_t &bytes) const {
+            if (buffer.size() == 0)
+                return SSL_ERROR_NONE;
+
+            ERR_clear_error();
+            const int ret = SSL_read_ex(ssl, buffer.data(), buffer.size(), &bytes);
+            return ret == 1 ? SSL_ERROR_NONE : SSL_get_error(ssl, ret);
+        }
+    };
+
+    //---------------------------------
+    struct Write {
+        static constexpr bool kTransfersBytes = true;
+
+        net::const_buffer buffer;
+
+        int operator()(SSL *ssl, std::size_t &bytes) const {
+            if (buffer.size() == 0)
+                return SSL_ERROR_NONE;
+
+            ERR_clear_error();
+            const int ret = SSL_write_ex(ssl, buffer.data(), buffer.size(), &bytes);
+            return ret == 1 ? SSL_ERROR_NONE : SSL_get_error(ssl, ret);
+        }
+    };
+
+    //---------------------------------
+    struct Shutdown {
+        static constexpr bool kTransfersBytes = false;
+
+        int operator()(SSL *ssl, std::size_t &) const {
+            ERR_clear_error();
+            // 0 means our close_notify is out; the peer's one is not needed
+            const int ret = SSL_shutdown(ssl);
+            return ret >= 0 ? SSL_ERROR_NONE : SSL_get_error(ssl, ret);
+        }
+    };
+
+} // end of namespace
+
+//-------------------------------------
+template <typename CompletionToken>
+auto
+TlsSocketStream::async_handshake(ssl::stream_base::handshake_type type, CompletionToken &&token) {
+    boost::ignore_unused(type);     // Client only
+    return net::async_compose<CompletionToken, void(beast::error_code)>(
+        TlsSocketOp<TlsSocketActions::Handshake>(*this, {}), token, mStream);
+}
+
+// Like asio's ssl::stream, only the first non empty buffer is used
+//-------------------------------------
+template <typename MutableBufferSequence, typename CompletionToken>
+auto
+TlsSocketStream::async_read_some(const MutableBufferSequence &buffers, CompletionToken &&token) {
+    net::mutable_buffer buffer;
+    for (auto it = net::buffer_sequence_begin(buffers); it != net::buffer_sequence_end(buffers); ++it) {
+        buffer = *it;
+        if (buffer.size() != 0)
+            break;
+    }
+
+    return net::async_compose<CompletionToken, void(beast::error_code, std::size_t)>(
+        TlsSocketOp<TlsSocketActions::Read>(*this, { buffer }), token, mStream);
+}
+
+// Scattered buffers (a websocket frame header plus its payload) are
+// gathered so they leave as one TLS record and one send()
+//-------------------------------------
+template <typename ConstBufferSequence, typename CompletionToken>
+auto
+TlsSocketStream::async_write_some(const ConstBufferSequence &buffers, CompletionToken &&token) {
+    net::const_buffer buffer;
+    auto it = net::buffer_sequence_begin(buffers);
+    for (; it != net::buffer_sequence_end(buffers); ++it) {
+        buffer = *it;
+        if (buffer.size() != 0)
+            break;
+    }
+
+    if (buffer.size() < kMaxRecord && it != net::buffer_sequence_end(buffers) && std::next(it) != net::buffer_sequence_end(buffers)) {
+        if (mWriteScratch == nullptr) {
+            mWriteScratch = std::make_unique<char[]>(kMaxRecord);
+        }
+        buffer = net::buffer(mWriteScratch.get(), net::buffer_copy(net::buffer(mWriteScratch.get(), kMaxRecord), buffers));
+    }
+
+    return net::async_compose<CompletionToken, void(beast::error_code, std::size_t)>(
+        TlsSocketOp<TlsSocketActions::Write>(*this, { buffer }), token, mStream);
+}
+
+//-------------------------------------
+template <typename CompletionToken>
+auto
+TlsSocketStream::async_shutdown(CompletionToken &&token) {
+    return net::async_compose<CompletionToken, void(beast::error_code)>(
+        TlsSocketOp<TlsSocketActions::Shutdown>(*this, {}), token, mStream);
+}
+
+// Found by ADL from websocket::stream when closing
+//-------------------------------------
+template <typename TeardownHandler>
+void
+async_teardown(beast::role_type role, TlsSocketStream &stream, TeardownHandler &&handler) {
+    boost::ignore_unused(role);
+    net::async_compose<TeardownHandler, void(beast::error_code)>(
+        [&stream, started = false](auto &self, beast::error_code ec = {}) mutable {
+            if (started == false) {
+                started = true;
+                return stream.async_shutdown(std::move(self));
+            }
+
+            // Peers often drop the connection instead of answering close_notify
+            if (ec == net::error::eof || ec == ssl::error::stream_truncated)
+                ec = {};
+
+            beast::error_code ignored;
+            stream.next_layer().socket().shutdown(tcp::socket::shutdown_both, ignored);
+            stream.next_layer().socket().close(ignored);
+            self.complete(ec);
+        }, handler, stream);
+}
@@ -2,28 +2,23 @@
 #include "log/logger.h"
 //--
 #include <boost/beast/websocket/ssl.hpp>
-#include <boost/beast/http.hpp>
-#include <boost/asio/strand.hpp>
 //--
 #include <nlohmann/json.hpp>
 //--
+#include <algorithm>
 #include <cstdint>
+#include <ctime>
 #include <string>
 #include <string_view>
 #include <functional>
+#include <type_traits>
+#include <utility>
 
 //-------------------------------------
 using namespace MindShake;
 
 using json = nlohmann::json;
 
-// Report a failure
-//-------------------------------------
-static void
-fail(beast::error_code ec, const char *function) {
-    Logger::error("{}: Beast Error {}: {}", function, ec.value(), ec.message());
-}
-
 // Utils
 //-------------------------------------
 static std::string
@@ -43,17 +38,49 @@ bufferToStringView(beast::flat_buffer &buffer) {
     return { data, size };
 }
 
+// CPU time of the calling thread, the process one would count the workers too
+//-------------------------------------
+static double
+threadCpuSeconds() {
+    timespec now {};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) != 0) {
+        return 0.0;
+    }
+    return double(now.tv_sec) + double(now.tv_nsec) * 1e-9;
+}
+
+//-------------------------------------
+template <typename WS>
+static constexpr bool kIsKTLS = std::is_same_v<typename std::decay_t<WS>::next_layer_type, TlsSocketStream>;
+
 //-------------------------------------
 constexpr const auto kConnectionTimeout = std::chrono::seconds(30);
+constexpr const auto kWriteBufferBytes  = std::size_t(16 * 1024);  // Max TLS record
+constexpr const auto kLoginResponseBytes = std::size_t(4 * 1024);
+constexpr const auto kFragmentBytes      = std::size_t(64 * 1024);  // Per async_read_some
 
 //-------------------------------------
-Session::Session(net::io_context &ioc, ssl::context &ctx)
-    : mResolver(net::make_strand(ioc))
-    , mStream(net::make_strand(ioc), ctx)
-    , mWS(net::make_strand(ioc), ctx)
+Session::Session(net::io_context &ioc, ssl::context &ctx, std::shared_ptr<HttpsClient> https)
+    : mHttps(https ? std::move(https) : std::make_shared<HttpsClient>(ioc, ctx))
+    , mCtx(ctx)
+    , mStrand(net::make_strand(ioc))
+    , mResolver(mStrand)
+    , mWS(std::in_place_type<SSLStream>, mStrand, ctx)
+    , mPingTimer(mStrand)
 {
 }
 
+//-------------------------------------
+void
+Session::setKernelTLS(bool enable) {
+    if (enable) {
+        mWS.emplace<KTLSStream>(mStrand, mCtx);
+    }
+    else {
+        mWS.emplace<SSLStream>(mStrand, mCtx);
+    }
+}
+
 //-------------------------------------
 bool
 Session::run(const std::string &host, const std::string &port, UserParserFunc userParser) {
@@ -76,67 +103,121 @@ Session::run(const std::string &host, const std::string &port, UserParserFunc us
     mPort = port;
     mUserParser = userParser;
 
-    // Look up the domain name
-    mResolver.async_resolve(host,port,beast::bind_front_handler(&Session::onResolve, shared_from_this()));
+    json body;
+    body["username"] = mUserName;
+    body["password"] = mPassword;
+    mLoginRequest = HttpsClient::makeRequest(http::verb::post, mHost, "/v1/sessions/", body.dump());
+    mLoginResponse.resize(kLoginResponseBytes);
+
+    // Log in through the shared client; its connection stays warm for later REST calls
+    HttpsRequest request;
+    request.bytes      = net::buffer(mLoginRequest);
+    request.body       = net::buffer(mLoginResponse);
+    request.deadline   = HttpsRequest::Clock::now() + kConnectionTimeout;
+    request.idempotent = true;
+    request.handler    = [self = shared_from_this()](beast::error_code ec, const HttpsResponse &res) {
+        net::post(self->mStrand, [self, ec, res]() {
+            self->onLogin(ec, res);
+        });
+    };
+    mHttps->async(mHost, mPort, std::move(request));
 
     return true;
 }
 
 //-------------------------------------
 void
-Session::onResolve(beast::error_code ec, tcp::resolver::results_type results) {
+Session::onLogin(beast::error_code ec, const HttpsResponse &res) {
     Logger::debug(__func__);
+
     if (ec) {
         return fail(ec, __func__);
     }
 
-    if (mToken.empty()) {
-        // Set a timeout on the operation
-        beast::get_lowest_layer(mStream).expires_after(kConnectionTimeout);
-        // Make the connection on the IP address we get from a lookup
-        beast::get_lowest_layer(mStream).async_connect(results, beast::bind_front_handler(&Session::onConnect, shared_from_this()));
+    // A bad body is a failed login, not an exception
+    bool ok = false;
+    const json data = json::parse(std::string_view(mLoginResponse.data(), res.bodySize), nullptr, false);
+    const json *token  = nullptr;
+    const json *status = nullptr;
+    if (data.is_object()) {
+        auto it = data.find("data");
+        token   = it != data.end() && it->is_string() ? &*it : nullptr;
+        it      = data.find("status");
+        status  = it != data.end() && it->is_string() ? &*it : nullptr;
+    }
+
+    if (data.is_discarded()) {
+        Logger::error("Error parsing JSON: login response");
+    }
+    else if (token == nullptr) {
+        Logger::error("Login response without a token");
     }
     else {
-        // Set a timeout on the operation
-        beast::get_lowest_layer(mWS).expires_after(kConnectionTimeout);
-        // Make the connection on the IP address we get from a lookup
-        beast::get_lowest_layer(mWS).async_connect(results, beast::bind_front_handler(&Session::onConnect, shared_from_this()));
+        mToken = token->get_ref<const std::string &>();
+        ok     = true;
+        Logger::debug("Token: '{}', status: '{}'", mToken, status ? status->get_ref<const std::string &>() : std::string());
+    }
+
+    if (ok == false) {
+        return done();
     }
+
+    if (mOnLogin) {
+        mOnLogin(mToken);
+    }
+
+    // Look up the domain name
+    mResolver.async_resolve(mHost, mPort, beast::bind_front_handler(&Session::onResolve, shared_from_this()));
 }
 
 //-------------------------------------
 void
-Session::onConnect(beast::error_code ec, tcp::resolver::results_type::endpoint_type ep) {
+Session::onResolve(beast::error_code ec, tcp::resolver::results_type results) {
     Logger::debug(__func__);
     if (ec) {
         return fail(ec, __func__);
     }
 
-    if (mToken.empty()) {
+    withWS([&](auto &ws) {
         // Set a timeout on the operation
-        beast::get_lowest_layer(mStream).expires_after(kConnectionTimeout);
+        beast::get_lowest_layer(ws).expires_after(kConnectionTimeout);
+        // Make the connection on the IP address we get from a lookup
+        beast::get_lowest_layer(ws).async_connect(results, beast::bind_front_handler(&Session::onConnect, shared_from_this()));
+    });
+}
 
-        // Perform the SSL handshake
-        mStream.async_handshake(ssl::stream_base::client, beast::bind_front_handler(&Session::onSSLHandshake, shared_from_this()));
+//-------------------------------------
+void
+Session::onConnect(beast::error_code ec, tcp::resolver::results_type::endpoint_type ep) {
+    Logger::debug(__func__);
+    if (ec) {
+        return fail(ec, __func__);
     }
-    else {
-        // Set a timeout on the operation
-        beast::get_lowest_layer(mWS).expires_after(kConnectionTimeout);
 
-        // Set SNI Hostname (many hosts need this to handshake successfully)
-        if (!SSL_set_tlsext_host_name(mWS.next_layer().native_handle(), mHost.c_str())) {
-            ec = beast::error_code(static_cast<int>(::ERR_get_error()), net::error::get_ssl_category());
-            return fail(ec, __func__);
-        }
+    // Set SNI Hostname (many hosts need this to handshake successfully)
+    SSL *handle = withWS([](auto &ws) { return ws.next_layer().native_handle(); });
+    if (!SSL_set_tlsext_host_name(handle, mHost.c_str())) {
+        ec = beast::error_code(static_cast<int>(::ERR_get_error()), net::error::get_ssl_category());
+        return fail(ec, __func__);
+    }
 
-        // Update the mHost string. This will provide the value of the
-        // Host HTTP header during the WebSocket handshake.
-        // See https://tools.ietf.org/html/rfc7230#section-5.4
-        mHost += ':' + std::to_string(ep.port());
+    // Update the mHost string. This will provide the value of the
+    // Host HTTP header during the WebSocket handshake.
+    // See https://tools.ietf.org/html/rfc7230#section-5.4
+    mHost += ':' + std::to_string(ep.port());
+
+    withWS([&](auto &ws) {
+        // Set a timeout on the handshake. With kTLS OpenSSL waits on the
+        // socket itself, so tcp_stream's one would not see it.
+        beast::get_lowest_layer(ws).expires_after(kConnectionTimeout);
+        if constexpr (kIsKTLS<decltype(ws)>) {
+            ws.next_layer().expires_after(kConnectionTimeout);
+            ws.next_layer().setKernelTLS(true);
+        }
 
         // Perform the SSL handshake
-        mWS.next_layer().async_handshake(ssl::stream_base::client, beast::bind_front_handler(&Session::onSSLHandshake, shared_from_this()));
-    }
+        ws.next_layer().async_handshake(ssl::stream_base::client, beast::bind_front_handler(&Session::onSSLHandshake, shared_from_this()));
+    });
 }
 
 //-------------------------------------
@@ -147,40 +228,43 @@ Session::onSSLHandshake(beast::error_code ec) {
         return fail(ec, __func__);
     }
 
-    if (mToken.empty()) {
-        mReq.version(11);
-        mReq.method(http::verb::post);
-        mReq.target("/v1/sessions/");
-        mReq.set(http::field::host, mHost);
-        mReq.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
-        mReq.set(http::field::content_type, "application/json");
-        json body;
-        body["username"] = mUserName;
-        body["password"] = mPassword;
-        mReq.body() = body.dump();
-        //mReq.body() = fmt::format(R"({{"username": "{}", "password": "{}"}})", mUserName, mPassword);
-        mReq.prepare_payload();
-
-        http::async_write(mStream, mReq, beast::bind_front_handler(&Session::onWritePost, shared_from_this()));
+    // Perform the websocket handshake
+    std::string target = "/v1/stream/?token=" + mToken;
+    if (mResumeToken.empty() == false) {
+        target += "&resume=" + mResumeToken;
     }
-    else {
+
+    withWS([&](auto &ws) {
+        if constexpr (kIsKTLS<decltype(ws)>) {
+            mFeedStats.kernelTLSRecv = ws.next_layer().isKernelTLSRecv();
+            mFeedStats.kernelTLSSend = ws.next_layer().isKernelTLSSend();
+            if (mFeedStats.kernelTLSRecv) {
+                Logger::debug("kTLS: receive offloaded to the kernel (send: {})", mFeedStats.kernelTLSSend);
+            }
+            else {
+                Logger::warning("kTLS: not enabled by the kernel or cipher, decrypting in user space");
+            }
+            ws.next_layer().expires_never();
+        }
 
         // Turn off the timeout on the tcp_stream, because
         // the websocket stream has its own timeout system.
-        beast::get_lowest_layer(mWS).expires_never();
+        beast::get_lowest_layer(ws).expires_never();
 
         // Set suggested timeout settings for the websocket
-        mWS.set_option(websocket::stream_base::timeout::suggested(beast::role_type::client));
+        ws.set_option(websocket::stream_base::timeout::suggested(beast::role_type::client));
+
+        // One frame per write, masked in TLS record sized chunks
+        ws.auto_fragment(false);
+        ws.write_buffer_bytes(kWriteBufferBytes);
 
         // Set a decorator to change the User-Agent of the handshake
-        mWS.set_option(websocket::stream_base::decorator([](websocket::request_type &req) {
+        ws.set_option(websocket::stream_base::decorator([](websocket::request_type &req) {
             req.set(http::field::user_agent, std::string(BOOST_BEAST_VERSION_STRING) + " websocket-client-async-ssl");
                        }));
 
-        // Perform the websocket handshake
-        std::string target = "/v1/stream/?token=" + mToken;
-        mWS.async_handshake(mHost, target, beast::bind_front_handler(&Session::onWSSHandshake, shared_from_this()));
-    }
+        ws.async_handshake(mHost, target, beast::bind_front_handler(&Session::onWSSHandshake, shared_from_this()));
+    });
 }
 
 //-------------------------------------
@@ -191,92 +275,209 @@ Session::onWSSHandshake(beast::error_code ec) {
         return fail(ec, __func__);
     }
 
-    mWS.async_read(mBuffer, beast::bind_front_handler(&Session::onReadData, shared_from_this()));
+    mFeedCpuStart = threadCpuSeconds();
+    readNext();
+
+    // Flush whatever was queued before the websocket was open
+    mWSOpen = true;
+    writeNext();
+    schedulePing();
 }
 
 //-------------------------------------
 void
-Session::onWritePost(beast::error_code ec, std::size_t bytesTransferred) {
-    boost::ignore_unused(bytesTransferred);
-    Logger::debug(__func__);
-
-    if (ec) {
-        return fail(ec, __func__);
-    }
+Session::send(std::string message) {
+    net::post(mStrand, [self = shared_from_this(), message = std::move(message), queued = MindShake::LatencyStats::Clock::now()]() mutable {
+        self->enqueue({ std::move(message), false, queued });
+    });
+}
 
-    // Read a message into our buffer
-    http::async_read(mStream, mBuffer, mRes, beast::bind_front_handler(&Session::onReadToken, shared_from_this()));
+//-------------------------------------
+void
+Session::sendPing() {
+    net::post(mStrand, [self = shared_from_this(), queued = MindShake::LatencyStats::Clock::now()]() mutable {
+        self->enqueue({ {}, true, queued });
+    });
 }
 
 //-------------------------------------
 void
-Session::onReadToken(beast::error_code ec, std::size_t bytesTransferred) {
-    boost::ignore_unused(bytesTransferred);
-    Logger::debug(__func__);
+Session::enqueue(Outgoing &&message) {
+    mWriteQueue.emplace_back(std::move(message));
 
-    if (ec) {
-        return fail(ec, __func__);
+    mWriteStats.queueDepth = mWriteQueue.size();
+    if (mWriteStats.queueDepth > mWriteStats.maxQueueDepth) {
+        mWriteStats.maxQueueDepth = mWriteStats.queueDepth;
     }
 
-    bool ok = true;
+    writeNext();
+}
 
-    try {
-        json data = json::parse(mRes.body());
+// Only one write may be in flight; reads keep going meanwhile. Every
+// text waiting is gathered into it, and pings wait behind them.
+//-------------------------------------
+void
+Session::writeNext() {
+    if (mWSOpen == false || mWriting || mWriteQueue.empty()) {
+        return;
+    }
 
-        mToken = data["data"];
+    mWriting = true;
+    if (mWriteQueue.front().ping) {
+        mInFlight = 1;
+        withWS([&](auto &ws) {
+            ws.async_ping({}, [self = shared_from_this()](beast::error_code ec) {
+                self->onWrite(ec, 0);
+            });
+        });
+        return;
+    }
 
-        std::string status = data["status"];
+    const auto texts = std::stable_partition(mWriteQueue.begin(), mWriteQueue.end(), [](const Outgoing &message) {
+        return message.ping == false;
+    });
+    mInFlight = std::size_t(texts - mWriteQueue.begin());
 
-        Logger::debug("Token: '{}', status: '{}'", mToken, status);
-    }
-    catch (const json::parse_error &e) {
-        Logger::error("Error parsing JSON: {}", e.what());
-        ok = false;
-    }
-    catch (const std::exception &e) {
-        Logger::error("Exception: {}", e.what());
-        ok = false;
-    }
-    catch (...) {
-        Logger::exception("Unknown exception occurred getting token");
-        ok = false;
+    mGather.clear();
+    for (auto it = mWriteQueue.begin(); it != texts; ++it) {
+        if (it != mWriteQueue.begin()) {
+            mGather.emplace_back(net::buffer(&kSeparator, 1));
+        }
+        mGather.emplace_back(net::buffer(it->payload));
     }
+    withWS([&](auto &ws) {
+        ws.async_write(mGather, beast::bind_front_handler(&Session::onWrite, shared_from_this()));
+    });
+}
 
-    mBuffer.consume(mBuffer.size());
+//-------------------------------------
+void
+Session::onWrite(beast::error_code ec, std::size_t bytesTransferred) {
+    mWriting = false;
 
-    if (ok) {
-        mResolver.async_resolve(mHost, mPort, beast::bind_front_handler(&Session::onResolve, shared_from_this()));
+    if (ec) {
+        mWriteQueue.clear();
+        mWriteStats.queueDepth = 0;
+        // closeWS() cut it short: the close handshake reports the outcome
+        if (mWSOpen == false && (ec == net::error::operation_aborted || ec == websocket::error::closed)) {
+            Logger::debug("{}: dropped while closing: {}", __func__, ec.message());
+            return;
+        }
+        return fail(ec, __func__);
     }
-    else {
-        mStream.async_shutdown(beast::bind_front_handler(&Session::onClose, shared_from_this()));
 
+    for (std::size_t i = 0; i < mInFlight; ++i) {
+        mWriteStats.latency.addSince(mWriteQueue.front().queued);
+        mWriteQueue.pop_front();
     }
+    mWriteStats.messages  += mInFlight;
+    mWriteStats.bytes     += bytesTransferred;
+    mWriteStats.queueDepth = mWriteQueue.size();
+
+    writeNext();
 }
 
 //-------------------------------------
 void
 Session::onReadData(beast::error_code ec, std::size_t bytesTransferred) {
-    boost::ignore_unused(bytesTransferred);
     Logger::debug(__func__);
 
     if (ec == websocket::error::closed) {
+        mWSOpen = false;
+        mPingTimer.cancel();
+        updateFeedStats();
         Logger::info("WebSocket connection closed");
-        return;
+        return done();
     }
     if (ec) {
+        mWSOpen = false;
+        mPingTimer.cancel();
+        updateFeedStats();
         return fail(ec, __func__);
     }
 
+    // Fragments only complete a frame at the end of the message
+    const bool last = mFragmentParser == nullptr || withWS([](auto &ws) { return ws.is_message_done(); });
+    mFeedStats.bytes  += bytesTransferred;
+    mFeedStats.frames += last;
+
+    // Closing: keep reading until the close frame, without parsing
+    if (mWSOpen == false) {
+        mBuffer.consume(mBuffer.size());
+        readNext();
+        return;
+    }
+
     auto received = bufferToStringView(mBuffer);
     //Logger::info("Received: {}", received);
-    bool syncFound = mUserParser(received);
+    bool syncFound = mFragmentParser ? mFragmentParser(received, last) : mUserParser(received);
     mBuffer.consume(mBuffer.size());
     if (syncFound == false) {
-        mWS.async_read(mBuffer, beast::bind_front_handler(&Session::onReadData, shared_from_this()));
+        readNext();
     }
     else {
-        mWS.async_close(websocket::close_code::normal, beast::bind_front_handler(&Session::onClose, shared_from_this()));
+        closeWS();
+    }
+}
+
+// Whole messages, or whatever has been decrypted so far
+//-------------------------------------
+void
+Session::readNext() {
+    withWS([&](auto &ws) {
+        if (mFragmentParser) {
+            ws.async_read_some(mBuffer, kFragmentBytes, beast::bind_front_handler(&Session::onReadData, shared_from_this()));
+        }
+        else {
+            ws.async_read(mBuffer, beast::bind_front_handler(&Session::onReadData, shared_from_this()));
+        }
+    });
+}
+
+//-------------------------------------
+void
+Session::close() {
+    net::post(mStrand, [self = shared_from_this()]() {
+        // The pending read goes on until the close reply
+        if (self->mWSOpen) {
+            self->closeWS();
+        }
+    });
+}
+
+//-------------------------------------
+void
+Session::closeWS() {
+    mWSOpen = false;
+    mPingTimer.cancel();
+    updateFeedStats();
+    withWS([&](auto &ws) {
+        ws.async_close(websocket::close_code::normal, beast::bind_front_handler(&Session::onClose, shared_from_this()));
+    });
+}
+
+// Cancelled once the websocket closes, so the io_context can run out of work
+//-------------------------------------
+void
+Session::schedulePing() {
+    if (mPingInterval == std::chrono::steady_clock::duration::zero()) {
+        return;
     }
+
+    mPingTimer.expires_after(mPingInterval);
+    mPingTimer.async_wait([self = shared_from_this()](beast::error_code ec) {
+        if (ec || self->mWSOpen == false) {
+            return;
+        }
+        self->enqueue({ {}, true, MindShake::LatencyStats::Clock::now() });
+        self->schedulePing();
+    });
+}
+
+//-------------------------------------
+void
+Session::updateFeedStats() {
+    mFeedStats.cpuSeconds = threadCpuSeconds() - mFeedCpuStart;
 }
 
 //-------------------------------------
@@ -288,4 +489,22 @@ Session::onClose(beast::error_code ec) {
     }
 
     // If we get here then the connection is closed gracefully
+    done();
+}
+
+// Report a failure
+//-------------------------------------
+void
+Session::fail(beast::error_code ec, const char *function) {
+    Logger::error("{}: Beast Error {}: {}", function, ec.value(), ec.message());
+    done();
+}
+
+// Once, whichever way the session ended
+//-------------------------------------
+void
+Session::done() {
+    if (mOnDone) {
+        std::exchange(mOnDone, nullptr)();
+    }
 }
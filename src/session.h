@@ -3,6 +3,17 @@
 #include <boost/beast/core.hpp>
 #include <boost/beast/websocket.hpp>
 #include <boost/asio/ssl.hpp>
+#include <boost/asio/strand.hpp>
+//--
+#include "net/httpsClient.h"
+#include "net/tlsSocketStream.h"
+#include "utils/latencyStats.h"
+//--
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <variant>
+#include <vector>
 
 //-------------------------------------
 namespace beast     = boost::beast;         // from <boost/beast.hpp>
@@ -12,35 +23,137 @@ namespace net       = boost::asio;          // from <boost/asio.hpp>
 namespace ssl       = boost::asio::ssl;     // from <boost/asio/ssl.hpp>
 using tcp           = boost::asio::ip::tcp; // from <boost/asio/ip/tcp.hpp>
 
+// Cost of reading the stream. CPU is the time of the io_context thread
+// from the websocket handshake on (worker threads are not counted), so
+// modes can be compared per MB.
+//-------------------------------------
+struct FeedStats {
+    uint64_t    bytes {};
+    uint64_t    frames {};
+    double      cpuSeconds {};
+    bool        kernelTLSRecv {};
+    bool        kernelTLSSend {};
+
+    double      megabytes() const       { return double(bytes) / (1024.0 * 1024.0); }
+    double      cpuMsPerMB() const      { return bytes ? cpuSeconds * 1000.0 / megabytes() : 0.0; }
+};
+
+// Outbound side of the websocket
+//-------------------------------------
+struct WriteStats {
+    std::size_t             queueDepth {};
+    std::size_t             maxQueueDepth {};
+    uint64_t                messages {};
+    uint64_t                bytes {};
+    MindShake::LatencyStats latency;    // queued -> written to the socket
+};
+
 //-------------------------------------
 class Session : public std::enable_shared_from_this<Session> {
     using UserParserFunc = std::function<bool(const std::string_view &)>;
+    using FragmentFunc   = std::function<bool(const std::string_view &fragment, bool last)>;
+    using LoginFunc      = std::function<void(const std::string &token)>;
+    using DoneFunc       = std::function<void()>;
+
+    struct Outgoing {
+        std::string                                 payload;
+        bool                                        ping {};
+        MindShake::LatencyStats::Clock::time_point  queued;
+    };
+
+    // asio's TLS by default; OpenSSL on the socket for kTLS
+    using SSLStream  = websocket::stream<ssl::stream<beast::tcp_stream>>;
+    using KTLSStream = websocket::stream<TlsSocketStream>;
+
+    static constexpr char kSeparator = '\n';   // Between gathered payloads
 
+    std::shared_ptr<HttpsClient> mHttps;    // HTTPS
+    ssl::context &mCtx;
+    net::strand<net::io_context::executor_type> mStrand;
     tcp::resolver mResolver;
-    ssl::stream<beast::tcp_stream> mStream; // HTTPS
-    websocket::stream<ssl::stream<beast::tcp_stream>> mWS;  // WSS
+    std::variant<SSLStream, KTLSStream> mWS;  // WSS
     beast::flat_buffer mBuffer;
     std::string mHost;
     std::string mPort;
     std::string mToken;
     std::string mUserName;
     std::string mPassword;
+    std::string mResumeToken;
     UserParserFunc mUserParser;
+    FragmentFunc mFragmentParser;
+    LoginFunc mOnLogin;
+    DoneFunc mOnDone;
+    FeedStats mFeedStats;
+    double mFeedCpuStart {};
 
-    http::request<http::string_body> mReq;
-    http::response<http::string_body> mRes;
+    std::deque<Outgoing> mWriteQueue;
+    std::vector<net::const_buffer> mGather;
+    std::size_t mInFlight {};               // Queue entries being written
+    WriteStats mWriteStats;
+    bool mWSOpen {};
+    bool mWriting {};
+    net::steady_timer mPingTimer;
+    std::chrono::steady_clock::duration mPingInterval {};
+
+    std::string mLoginRequest;
+    std::string mLoginResponse;
 
 public:
-    // Resolver and socket require an io_context
-    explicit Session(net::io_context &ioc, ssl::context &ctx);
+    // Resolver and socket require an io_context. REST calls go through
+    // https, so they can share connections with other components.
+    explicit Session(net::io_context &ioc, ssl::context &ctx, std::shared_ptr<HttpsClient> https = nullptr);
 
     // Set credentials before calling run
     void setCredentials(const std::string &user, const std::string &password) { mUserName = user, mPassword = password;  }
 
+    // Opt-in: let the kernel decrypt the websocket (Linux, OpenSSL 3).
+    // Falls back to user space decryption when not supported. Before run.
+    void setKernelTLS(bool enable);
+
+    // Attach the stream from a previous sync token instead of from scratch
+    void setResumeToken(const std::string &token) { mResumeToken = token; }
+
+    // Opt-in: the stream is handed over as it is decrypted instead of one
+    // whole message at a time; last marks the end of each message. Used
+    // instead of the parser given to run(). True stops the stream.
+    void setFragmentParser(FragmentFunc parser) { mFragmentParser = std::move(parser); }
+
+    // Opt-in: keep-alive pings through the write queue while the websocket
+    // is open. Their latency shows up in the write stats.
+    void setPingInterval(std::chrono::steady_clock::duration interval) { mPingInterval = interval; }
+
+    // Runs on the session strand once logged in, before the stream is attached
+    void setLoginHandler(LoginFunc onLogin) { mOnLogin = std::move(onLogin); }
+
+    // Runs on the session strand once the stream is over, closed or failed.
+    // The shared HttpsClient keeps its connections: stop it when done with it.
+    void setDoneHandler(DoneFunc onDone) { mOnDone = std::move(onDone); }
+
+    // Session token, once logged in. Other REST clients need it too.
+    const std::string &getToken() const { return mToken; }
+
+    // Valid once the websocket is closed
+    const FeedStats &getFeedStats() const { return mFeedStats; }
+
+    // Valid once the io_context has stopped
+    const WriteStats &getWriteStats() const { return mWriteStats; }
+
+    // Thread safe. Written in order on the session strand, held until the
+    // websocket is open. Messages queued while a write is in flight go out
+    // together, newline separated (JSON lines), in one text frame and one
+    // send(). Pings are separate control frames, and may overtake them.
+    void send(std::string message);
+    void sendPing();
+
+    // Thread safe. Closes the websocket without waiting for sync.
+    void close();
+
     // Start the asynchronous operation
     bool run(const std::string &host, const std::string &port, UserParserFunc userParser);
 
 protected:
+    void onLogin(beast::error_code ec, const HttpsResponse &res);
+
     void onResolve(beast::error_code ec, tcp::resolver::results_type results);
 
     void onConnect(beast::error_code ec, tcp::resolver::results_type::endpoint_type ep);
@@ -49,11 +162,29 @@ protected:
 
     void onWSSHandshake(beast::error_code ec);
 
-    void onWritePost(beast::error_code ec, std::size_t bytes_transferred);
-    
-    void onReadToken(beast::error_code ec, std::size_t bytes_transferred);
+    void readNext();
 
     void onReadData(beast::error_code ec, std::size_t bytes_transferred);
 
     void onClose(beast::error_code ec);
+
+    void fail(beast::error_code ec, const char *function);
+
+    void done();
+
+    void closeWS();
+
+    void schedulePing();
+
+    void updateFeedStats();
+
+    void enqueue(Outgoing &&message);
+
+    void writeNext();
+
+    void onWrite(beast::error_code ec, std::size_t bytes_transferred);
+
+    // Calls func with the websocket stream in use
+    template <typename Func>
+    decltype(auto) withWS(Func &&func) { return std::visit(std::forward<Func>(func), mWS); }
 };
\ No newline at end of file
@@ -0,0 +1,189 @@
+#include "decimal.h"
+//--
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ || defined(_MSC_VER)
+    #define kDecimalSWAR
+#endif
+
+//-------------------------------------
+namespace MindShake {
+
+    static constexpr uint64_t kPow10[20] = {
+        1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+        1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+        100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+        1000000000000000000ull, 10000000000000000000ull,
+    };
+
+    static constexpr uint64_t kMaxRaw         = uint64_t(INT64_MAX);
+    static constexpr int      kMaxWholeDigits = 11;     // 92233720368
+    static constexpr int      kMaxExponent    = 19;
+
+    //---------------------------------
+    static inline unsigned
+    digitOf(char c) {
+        return unsigned(uint8_t(c) - uint8_t('0'));
+    }
+
+#if defined(kDecimalSWAR)
+    // Eight ASCII digits at once, as a little endian word
+    //---------------------------------
+    static inline uint64_t
+    load8(const char *text) {
+        uint64_t word;
+        std::memcpy(&word, text, sizeof(word));
+        return word;
+    }
+
+    //---------------------------------
+    static inline bool
+    isEightDigits(uint64_t word) {
+        return (((word & 0xF0F0F0F0F0F0F0F0ull) | (((word + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) == 0x3333333333333333ull);
+    }
+
+    // First digit is the most significant
+    //---------------------------------
+    static inline uint64_t
+    parseEightDigits(uint64_t word) {
+        word -= 0x3030303030303030ull;
+        word  = (word * 10) + (word >> 8);
+        word  = (((word & 0x000000FF000000FFull) * 0x000F424000000064ull) + (((word >> 16) & 0x000000FF000000FFull) * 0x0000271000000001ull)) >> 32;
+        return word;
+    }
+#endif
+
+    //---------------------------------
+    Decimal
+    Decimal::fromDouble(double value) {
+        return Decimal { std::llround(value * double(kScale)) };
+    }
+
+    //---------------------------------
+    const char *
+    Decimal::parse(const char *begin, const char *end, Decimal &out) {
+        const char *p        = begin;
+        const bool  negative = p < end && *p == '-';
+        p += negative;
+
+        // Whole part
+        const char *digits = p;
+        uint64_t    whole  = 0;
+        while (p < end && digitOf(*p) < 10) {
+            whole = whole * 10 + digitOf(*p++);     // Wraps harmlessly when too long
+        }
+        if (p == digits || p - digits > kMaxWholeDigits) {
+            return nullptr;
+        }
+
+        // Fraction, rounded to kDecimals
+        uint64_t fraction = 0;
+        bool     roundUp  = false;
+        if (p < end && *p == '.') {
+            digits = ++p;
+#if defined(kDecimalSWAR)
+            // Rates come with eight decimals: all of them in one go
+            if (end - p >= 8 && isEightDigits(load8(p))) {
+                fraction = parseEightDigits(load8(p));
+                p += 8;
+            }
+            else
+#endif
+            {
+                while (p < end && p - digits < kDecimals && digitOf(*p) < 10) {
+                    fraction = fraction * 10 + digitOf(*p++);
+                }
+                fraction *= kPow10[kDecimals - (p - digits)];
+            }
+            if (p == digits) {
+                return nullptr;
+            }
+            if (p < end && digitOf(*p) < 10) {
+                roundUp = *p >= '5';
+                while (p < end && digitOf(*p) < 10) {
+                    ++p;
+                }
+            }
+        }
+
+        uint64_t value = whole * uint64_t(kScale) + fraction + roundUp;
+
+        // Exponents are rare in the feed; they scale the rounded value
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            ++p;
+            const bool negativeExp = p < end && *p == '-';
+            p += p < end && (*p == '-' || *p == '+');
+
+            digits = p;
+            int exponent = 0;
+            while (p < end && digitOf(*p) < 10) {
+                exponent = std::min(exponent * 10 + int(digitOf(*p++)), kMaxExponent + 1);
+            }
+            if (p == digits) {
+                return nullptr;
+            }
+
+            if (negativeExp) {
+                if (exponent > kMaxExponent) {
+                    value = 0;
+                }
+                else {
+                    const uint64_t divisor   = kPow10[exponent];
+                    const uint64_t remainder = value % divisor;
+                    value = value / divisor + (remainder >= divisor - remainder);
+                }
+            }
+            else if (value != 0) {
+                if (exponent > kMaxExponent || value > kMaxRaw / kPow10[exponent]) {
+                    return nullptr;
+                }
+                value *= kPow10[exponent];
+            }
+        }
+
+        if (value > kMaxRaw) {
+            return nullptr;
+        }
+        out.raw = negative ? -int64_t(value) : int64_t(value);
+        return p;
+    }
+
+    //---------------------------------
+    bool
+    Decimal::parse(std::string_view text, Decimal &out) {
+        const char *end = text.data() + text.size();
+        return text.empty() == false && parse(text.data(), end, out) == end;
+    }
+
+    //---------------------------------
+    std::size_t
+    Decimal::format(char *buffer) const {
+        char    *p        = buffer;
+        uint64_t absolute = raw < 0 ? 0 - uint64_t(raw) : uint64_t(raw);
+        if (raw < 0) {
+            *p++ = '-';
+        }
+
+        p = std::to_chars(p, buffer + 24, absolute / uint64_t(kScale)).ptr;
+
+        uint64_t fraction = absolute % uint64_t(kScale);
+        if (fraction != 0) {
+            int decimals = kDecimals;
+            while (fraction % 10 == 0) {
+                fraction /= 10;
+                --decimals;
+            }
+            *p++ = '.';
+            for (int i = decimals - 1; i >= 0; --i) {
+                p[i] = char('0' + fraction % 10);
+                fraction /= 10;
+            }
+            p += decimals;
+        }
+        return std::size_t(p - buffer);
+    }
+
+} // end of namespace
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+//-------------------------------------
+namespace MindShake {
+
+    // Fixed-point number with eight decimals, stored as a scaled int64:
+    // odds, stakes, balances and rates compare exactly and hash as one
+    // integer. Range is about +/-9.2e10.
+    //---------------------------------
+    struct Decimal {
+        static constexpr int     kDecimals = 8;
+        static constexpr int64_t kScale    = 100000000;
+
+        int64_t raw {};
+
+        static constexpr Decimal fromRaw(int64_t raw)   { return Decimal { raw }; }
+        static Decimal  fromDouble(double value);       // Rounded to the nearest step
+
+        double          toDouble() const                { return double(raw) / double(kScale); }
+
+        // Like std::from_chars over a JSON number: returns the end of what
+        // was parsed, or nullptr if it is not a number or out of range.
+        // Digits past the eighth decimal are rounded half away from zero.
+        static const char *parse(const char *begin, const char *end, Decimal &out);
+
+        // Whole text must be a number
+        static bool     parse(std::string_view text, Decimal &out);
+
+        // Shortest text, without trailing zeros; buffer needs 24 bytes
+        std::size_t     format(char *buffer) const;
+
+        constexpr Decimal operator-() const                     { return Decimal { -raw }; }
+        constexpr Decimal operator+(Decimal other) const        { return Decimal { raw + other.raw }; }
+        constexpr Decimal operator-(Decimal other) const        { return Decimal { raw - other.raw }; }
+
+        constexpr bool  operator==(Decimal other) const         { return raw == other.raw; }
+        constexpr bool  operator!=(Decimal other) const         { return raw != other.raw; }
+        constexpr bool  operator<(Decimal other) const          { return raw <  other.raw; }
+        constexpr bool  operator<=(Decimal other) const         { return raw <= other.raw; }
+        constexpr bool  operator>(Decimal other) const          { return raw >  other.raw; }
+        constexpr bool  operator>=(Decimal other) const         { return raw >= other.raw; }
+    };
+
+} // end of namespace
+
+//-------------------------------------
+template <>
+struct std::hash<MindShake::Decimal> {
+    std::size_t operator()(MindShake::Decimal value) const noexcept { return std::hash<int64_t>()(value.raw); }
+};
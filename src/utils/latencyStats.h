@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+//-------------------------------------
+namespace MindShake {
+
+    // Running count / min / max / mean of a latency
+    //---------------------------------
+    class LatencyStats {
+        public:
+            using Clock    = std::chrono::steady_clock;
+            using Duration = std::chrono::nanoseconds;
+
+        public:
+            void add(Duration value) {
+                const auto ns = static_cast<uint64_t>(value.count() > 0 ? value.count() : 0);
+                mCount += 1;
+                mTotal += ns;
+                if (ns < mMin) mMin = ns;
+                if (ns > mMax) mMax = ns;
+            }
+
+            void addSince(Clock::time_point start) { add(Clock::now() - start); }
+
+            void reset() { *this = LatencyStats(); }
+
+            uint64_t    count() const   { return mCount; }
+            double      minUs() const   { return mCount ? double(mMin) / 1000.0 : 0.0; }
+            double      maxUs() const   { return double(mMax) / 1000.0; }
+            double      meanUs() const  { return mCount ? double(mTotal) / double(mCount) / 1000.0 : 0.0; }
+
+        protected:
+            uint64_t    mCount {};
+            uint64_t    mTotal {};
+            uint64_t    mMin { std::numeric_limits<uint64_t>::max() };
+            uint64_t    mMax {};
+    };
+
+} // end of namespace
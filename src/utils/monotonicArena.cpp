@@ -0,0 +1,62 @@
+#include "monotonicArena.h"
+
+//-------------------------------------
+namespace MindShake {
+
+    //---------------------------------
+    thread_local MonotonicArena *MonotonicArena::sCurrent = nullptr;
+
+    //---------------------------------
+    MonotonicArena::MonotonicArena(std::size_t chunkBytes)
+        : mChunkBytes(chunkBytes)
+    {
+    }
+
+    //---------------------------------
+    MonotonicArena::~MonotonicArena() {
+        release();
+    }
+
+    //---------------------------------
+    void
+    MonotonicArena::reset() {
+        mChunk  = 0;
+        mOffset = 0;
+        ++mStats.resets;
+    }
+
+    //---------------------------------
+    void
+    MonotonicArena::release() {
+        for (auto &chunk : mChunks) {
+            ::operator delete(chunk.data);
+        }
+        mChunks.clear();
+        reset();
+    }
+
+    // Moves on to the next chunk that fits, adding one if needed
+    //---------------------------------
+    void *
+    MonotonicArena::allocateSlow(std::size_t bytes, std::size_t align) {
+        const std::size_t needed = bytes + align;
+
+        if (mChunks.empty() == false) {
+            ++mChunk;
+        }
+        while (mChunk < mChunks.size() && mChunks[mChunk].size < needed) {
+            ++mChunk;
+        }
+
+        if (mChunk == mChunks.size()) {
+            const std::size_t size = needed > mChunkBytes ? needed : mChunkBytes;
+            mChunks.push_back({ static_cast<std::byte *>(::operator new(size)), size });
+            ++mStats.chunks;
+            mStats.chunkBytes += size;
+        }
+
+        mOffset = 0;
+        return allocate(bytes, align);
+    }
+
+} // end of namespace
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+//-------------------------------------
+namespace MindShake {
+
+    // Bump allocator over a list of chunks. Nothing is freed one by one:
+    // reset() rewinds it, keeping the chunks for the next round, so a
+    // warmed up arena does no heap allocation at all.
+    // Not thread safe; one arena per thread or per job.
+    //---------------------------------
+    class MonotonicArena {
+        public:
+            struct Stats {
+                uint64_t    chunks {};          // Heap allocations done by the arena
+                uint64_t    chunkBytes {};
+                uint64_t    allocations {};     // Served from the chunks
+                uint64_t    bytes {};
+                uint64_t    resets {};
+            };
+
+        public:
+            explicit    MonotonicArena(std::size_t chunkBytes = 64 * 1024);
+                        ~MonotonicArena();
+
+            MonotonicArena(const MonotonicArena &) = delete;
+            MonotonicArena &operator=(const MonotonicArena &) = delete;
+
+            void       *allocate(std::size_t bytes, std::size_t align = alignof(std::max_align_t)) {
+                std::size_t offset = (mOffset + align - 1) & ~(align - 1);
+                if (mChunk < mChunks.size() && offset + bytes <= mChunks[mChunk].size) {
+                    mOffset = offset + bytes;
+                    ++mStats.allocations;
+                    mStats.bytes += bytes;
+                    return mChunks[mChunk].data + offset;
+                }
+                return allocateSlow(bytes, align);
+            }
+
+            // Everything allocated so far becomes invalid
+            void        reset();
+
+            // reset() and give the chunks back to the heap
+            void        release();
+
+            const Stats &getStats() const   { return mStats; }
+
+            // Arena of the innermost ArenaScope on this thread, if any
+            static MonotonicArena *current() { return sCurrent; }
+
+        protected:
+            struct Chunk {
+                std::byte   *data;
+                std::size_t size;
+            };
+
+        protected:
+            void       *allocateSlow(std::size_t bytes, std::size_t align);
+
+        protected:
+            std::vector<Chunk>  mChunks;
+            std::size_t         mChunk {};      // Chunk being filled
+            std::size_t         mOffset {};
+            std::size_t         mChunkBytes;
+            Stats               mStats;
+
+            static thread_local MonotonicArena *sCurrent;
+
+            friend class ArenaScope;
+    };
+
+    // Routes ArenaAllocator on this thread to arena while alive
+    //---------------------------------
+    class ArenaScope {
+        public:
+            explicit    ArenaScope(MonotonicArena &arena) : mPrevious(MonotonicArena::sCurrent) { MonotonicArena::sCurrent = &arena; }
+                        ~ArenaScope()                                                        { MonotonicArena::sCurrent = mPrevious; }
+
+            ArenaScope(const ArenaScope &) = delete;
+            ArenaScope &operator=(const ArenaScope &) = delete;
+
+        protected:
+            MonotonicArena  *mPrevious;
+    };
+
+    // Stateless allocator for containers that default construct theirs
+    // (nlohmann::basic_json does). Inside an ArenaScope it allocates from
+    // the arena and never frees; outside it is the global heap.
+    // Objects must be created and destroyed inside the same scope.
+    //---------------------------------
+    template <typename T>
+    struct ArenaAllocator {
+        using value_type = T;
+
+        ArenaAllocator() noexcept = default;
+
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U> &) noexcept { }
+
+        T *allocate(std::size_t count) {
+            if (MonotonicArena *arena = MonotonicArena::current()) {
+                return static_cast<T *>(arena->allocate(count * sizeof(T), alignof(T)));
+            }
+            return static_cast<T *>(::operator new(count * sizeof(T)));
+        }
+
+        void deallocate(T *ptr, std::size_t) noexcept {
+            if (MonotonicArena::current() == nullptr) {
+                ::operator delete(ptr);
+            }
+        }
+
+        template <typename U>
+        bool operator==(const ArenaAllocator<U> &) const noexcept { return true; }
+
+        template <typename U>
+        bool operator!=(const ArenaAllocator<U> &) const noexcept { return false; }
+    };
+
+} // end of namespace
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+//-------------------------------------
+namespace MindShake {
+
+    // FNV-1a with a seed mixed into the offset basis
+    //---------------------------------
+    constexpr uint32_t
+    hashBytes(std::string_view key, uint32_t seed) {
+        uint32_t hash = 2166136261u ^ (seed * 0x9E3779B9u);
+        for (char c : key) {
+            hash ^= uint8_t(c);
+            hash *= 16777619u;
+        }
+        return hash ^ (hash >> 15);
+    }
+
+    // Power of two with at least twice as many slots as keys
+    //---------------------------------
+    constexpr std::size_t
+    perfectHashSlots(std::size_t keys) {
+        std::size_t slots = 1;
+        while (slots < keys * 2) {
+            slots *= 2;
+        }
+        return slots;
+    }
+
+    // Collision free table over a fixed key set, built at compile time:
+    // a lookup is one hash of the key bytes plus one compare.
+    //---------------------------------
+    template <std::size_t N>
+    struct PerfectHash {
+        static constexpr std::size_t kSlots    = perfectHashSlots(N);
+        static constexpr std::size_t kNotFound = N;
+
+        static_assert(N < 255, "Slots hold 8 bit indices");
+
+        std::array<std::string_view, N> keys {};
+        std::array<uint8_t, kSlots>     slots {};   // Key index + 1, 0 when empty
+        uint32_t                        seed {};
+        bool                            valid {};
+
+        // Slot a key hashes to, whether it is one of the keys or not. Usable
+        // as a case label, for generated code that switches on it.
+        constexpr std::size_t slot(std::string_view key) const {
+            return hashBytes(key, seed) & (kSlots - 1);
+        }
+
+        // Index of key, kNotFound if it is not one of the keys
+        constexpr std::size_t find(std::string_view key) const {
+            const uint8_t index = slots[slot(key)];
+            return index != 0 && keys[index - 1] == key ? index - 1 : kNotFound;
+        }
+    };
+
+    // Tries seeds until no two keys share a slot; valid stays false if
+    // none does (or keys repeat), for a static_assert to catch
+    //---------------------------------
+    template <std::size_t N>
+    constexpr PerfectHash<N>
+    makePerfectHash(const std::array<std::string_view, N> &keys) {
+        PerfectHash<N> table {};
+        table.keys = keys;
+
+        for (uint32_t seed = 0; seed < 4096; ++seed) {
+            std::array<uint8_t, PerfectHash<N>::kSlots> slots {};
+            bool collision = false;
+            for (std::size_t i = 0; i < N && collision == false; ++i) {
+                auto &slot = slots[hashBytes(keys[i], seed) & (PerfectHash<N>::kSlots - 1)];
+                collision  = slot != 0;
+                slot       = uint8_t(i + 1);
+            }
+
+            if (collision == false) {
+                table.slots = slots;
+                table.seed  = seed;
+                table.valid = true;
+                break;
+            }
+        }
+        return table;
+    }
+
+} // end of namespace
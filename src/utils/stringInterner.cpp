@@ -0,0 +1,77 @@
+#include "stringInterner.h"
+#include "perfectHash.h"
+//--
+#include <cstring>
+
+//-------------------------------------
+namespace MindShake {
+
+    //---------------------------------
+    StringInterner::StringInterner(std::size_t capacity) {
+        mEntries.reserve(capacity);
+        mSlots.assign(perfectHashSlots(capacity), kInvalid);
+    }
+
+    //---------------------------------
+    StringInterner::Id
+    StringInterner::intern(std::string_view name) {
+        const uint32_t hash = hashBytes(name, 0);
+        std::size_t slot = probe(name, hash);
+        if (mSlots[slot] != kInvalid) {
+            return mSlots[slot];
+        }
+
+        // Keep the load under one half
+        if ((mEntries.size() + 1) * 2 > mSlots.size()) {
+            grow();
+            slot = probe(name, hash);
+        }
+
+        auto *data = static_cast<char *>(mArena.allocate(name.size(), 1));
+        std::memcpy(data, name.data(), name.size());
+
+        const Id id = Id(mEntries.size());
+        mEntries.push_back({ data, uint32_t(name.size()), hash });
+        mSlots[slot] = id;
+        return id;
+    }
+
+    //---------------------------------
+    StringInterner::Id
+    StringInterner::find(std::string_view name) const {
+        return mSlots[probe(name, hashBytes(name, 0))];
+    }
+
+    // Linear probing; the table is never full
+    //---------------------------------
+    std::size_t
+    StringInterner::probe(std::string_view name, uint32_t hash) const {
+        const std::size_t mask = mSlots.size() - 1;
+        for (std::size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+            const Id id = mSlots[slot];
+            if (id == kInvalid) {
+                return slot;
+            }
+            const auto &entry = mEntries[id];
+            if (entry.hash == hash && get(id) == name) {
+                return slot;
+            }
+        }
+    }
+
+    // Entries keep their hash: rehashing touches no string bytes
+    //---------------------------------
+    void
+    StringInterner::grow() {
+        mSlots.assign(mSlots.size() * 2, kInvalid);
+        const std::size_t mask = mSlots.size() - 1;
+        for (Id id = 0; id < mEntries.size(); ++id) {
+            std::size_t slot = mEntries[id].hash & mask;
+            while (mSlots[slot] != kInvalid) {
+                slot = (slot + 1) & mask;
+            }
+            mSlots[slot] = id;
+        }
+    }
+
+} // end of namespace
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "monotonicArena.h"
+//--
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+//-------------------------------------
+namespace MindShake {
+
+    // Maps names to small stable ids. The bytes are copied once into an
+    // append-only arena; lookups go through a flat open addressing table
+    // of ids, so a name seen before costs one hash and one compare, and
+    // no allocation. Views returned by get() live as long as the interner.
+    // Not thread safe.
+    //---------------------------------
+    class StringInterner {
+        public:
+            using Id = uint32_t;
+
+            static constexpr Id kInvalid = ~Id(0);
+
+        public:
+            explicit    StringInterner(std::size_t capacity = 1024);
+
+            // Id of name, added if new
+            Id          intern(std::string_view name);
+
+            // Id of name, kInvalid if it was never interned
+            Id          find(std::string_view name) const;
+
+            std::string_view get(Id id) const       { return { mEntries[id].data, mEntries[id].size }; }
+
+            // Ids go from 0 to size() - 1, in interning order
+            std::size_t size() const                { return mEntries.size(); }
+            std::size_t getBytes() const            { return mArena.getStats().bytes; }
+
+        protected:
+            struct Entry {
+                const char  *data;
+                uint32_t    size;
+                uint32_t    hash;
+            };
+
+        protected:
+            // Slot holding name, or the empty slot where it would go
+            std::size_t probe(std::string_view name, uint32_t hash) const;
+
+            void        grow();
+
+        protected:
+            MonotonicArena      mArena { 16 * 1024 };
+            std::vector<Entry>  mEntries;       // By id
+            std::vector<Id>     mSlots;         // kInvalid when empty
+    };
+
+} // end of namespace
@@ -0,0 +1,63 @@
+#include "workerPool.h"
+
+//-------------------------------------
+namespace MindShake {
+
+    //---------------------------------
+    WorkerPool::WorkerPool(std::size_t threads) {
+        if (threads == 0) {
+            threads = std::thread::hardware_concurrency();
+        }
+        if (threads == 0) {
+            threads = 1;
+        }
+
+        mThreads.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i) {
+            mThreads.emplace_back(&WorkerPool::run, this);
+        }
+    }
+
+    // Pending jobs still run before the threads leave
+    //---------------------------------
+    WorkerPool::~WorkerPool() {
+        {
+            std::lock_guard guard(mMutex);
+            mStopping = true;
+        }
+        mCondition.notify_all();
+
+        for (auto &thread : mThreads) {
+            thread.join();
+        }
+    }
+
+    //---------------------------------
+    void
+    WorkerPool::post(Job job) {
+        {
+            std::lock_guard guard(mMutex);
+            mJobs.emplace_back(std::move(job));
+        }
+        mCondition.notify_one();
+    }
+
+    //---------------------------------
+    void
+    WorkerPool::run() {
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock lock(mMutex);
+                mCondition.wait(lock, [this] { return mStopping || mJobs.empty() == false; });
+                if (mJobs.empty()) {
+                    return;
+                }
+                job = std::move(mJobs.front());
+                mJobs.pop_front();
+            }
+            job();
+        }
+    }
+
+} // end of namespace
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//-------------------------------------
+namespace MindShake {
+
+    // Fixed set of threads running posted jobs in FIFO order
+    //---------------------------------
+    class WorkerPool {
+        public:
+            using Job = std::function<void()>;
+
+        public:
+            // 0 means one per hardware thread
+            explicit    WorkerPool(std::size_t threads = 0);
+                        ~WorkerPool();
+
+            WorkerPool(const WorkerPool &) = delete;
+            WorkerPool &operator=(const WorkerPool &) = delete;
+
+            void        post(Job job);
+
+            std::size_t size() const { return mThreads.size(); }
+
+        protected:
+            void        run();
+
+        protected:
+            std::vector<std::thread>    mThreads;
+            std::deque<Job>             mJobs;
+            std::mutex                  mMutex;
+            std::condition_variable     mCondition;
+            bool                        mStopping {};
+    };
+
+} // end of namespace
@@ -0,0 +1,138 @@
+//------------------------------------------------------------------------------
+// JsonTape against malformed frames: every kernel of the structural index
+// must reject what nlohmann::json rejects, and keep accepting valid input.
+//
+// Usage: jsonTapeTest
+//------------------------------------------------------------------------------
+
+#include "feed/jsonTape.h"
+//--
+#include <nlohmann/json.hpp>
+//--
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+
+//-------------------------------------
+static int gFailures = 0;
+
+//-------------------------------------
+static void
+expect(bool ok, const char *what, std::string_view json, Molly::StructuralIndex::Isa isa) {
+    if (ok == false) {
+        ++gFailures;
+        std::printf("FAIL %-28s [%s] %.*s\n", what, Molly::StructuralIndex::getName(isa), int(json.size()), json.data());
+    }
+}
+
+// Both quotes and what sits right after a string, with and without padding
+// to put it across a 64 byte block boundary
+//-------------------------------------
+static void
+checkFixed(Molly::JsonTape &tape, Molly::StructuralIndex::Isa isa) {
+    static const char *kMalformed[] = {
+        R"(["a"false])",
+        R"({"a":"b"1})",
+        R"({"k"x:1})",
+        R"({"data":[{"x":"y"garbage}]})",
+        R"(["a""b"])",
+        R"([1x])",
+        R"([1 2])",
+        R"([-])",
+        R"([01])",
+        R"([1.])",
+        R"([.5])",
+        R"([1e])",
+        R"([1e+])",
+        R"([--1])",
+        R"([tru])",
+        R"([truex])",
+        R"({"a":1,})",
+        R"([1,])",
+        R"({"a"})",
+        R"({"a":})",
+        R"({1:2})",
+        R"(["a")",
+        R"({"ts": 1.5, "data": [["event", {"event_id": "e1"}])",
+    };
+    static const char *kValid[] = {
+        R"(["a",false])",
+        R"({"a":"b","c":1})",
+        R"({"k" : 1})",
+        R"([0, -0, 1.5, -2e10, 3E+2, 4.25e-3, true, false, null])",
+        R"(["a\"b", "c\\", "d"])",
+        R"({"ts": 1714566600.5, "data": [["event", {"event_id": "2024-05-01,1,2", "home": "Team é"}], ["sync", {"token": "t"}]]})",
+        R"(  [ "a" , 1 ]  )",
+    };
+
+    for (const auto *text : kMalformed) {
+        for (std::size_t pad : { 0, 1, 58, 60, 61, 62, 63 }) {
+            const std::string json = std::string(pad, ' ') + text;
+            expect(tape.parse(json) == false, "malformed accepted", json, isa);
+        }
+    }
+    for (const auto *text : kValid) {
+        for (std::size_t pad : { 0, 1, 58, 60, 61, 62, 63 }) {
+            const std::string json = std::string(pad, ' ') + text;
+            expect(tape.parse(json), "valid rejected", json, isa);
+        }
+    }
+
+    // What the tape holds, not only the verdict
+    if (tape.parse(R"(["a",false])")) {
+        expect(tape.size() == 3 && tape[2].kind == Molly::JsonTape::Kind::False, "wrong tape", R"(["a",false])", isa);
+    }
+}
+
+// Random edits of a stream frame. String contents are not validated by the
+// tape, so the edits only use bytes that change the structure or scalars.
+//-------------------------------------
+static void
+checkMutations(Molly::JsonTape &tape, Molly::StructuralIndex::Isa isa) {
+    static const std::string kFrame =
+        R"({"ts": 1714566600.5, "data": [["event", {"sport": "fb", "event_id": "2024-05-01,1,2", "competition_id": 8, "home": "Team A"}], )"
+        R"(["offer", {"event_id": "2024-05-01,1,2", "bet_type": "for,ah,h,-2", "price": 1.95, "min": ["EUR", 5.0], "live": true, "x": null}]]})";
+    static constexpr std::string_view kBytes = "{}[]:,\" 0123456789-.eEtrufalsnx";
+
+    std::mt19937 rng(7);
+    for (int i = 0; i < 20000; ++i) {
+        std::string json = kFrame;
+        for (int edits = 1 + int(rng() % 3); edits > 0; --edits) {
+            const std::size_t pos = rng() % json.size();
+            const char        c   = kBytes[rng() % kBytes.size()];
+            switch (rng() % 3) {
+                case 0:  json[pos] = c;             break;
+                case 1:  json.insert(pos, 1, c);    break;
+                default: json.erase(pos, 1);        break;
+            }
+        }
+
+        const bool expected = nlohmann::json::accept(json);
+        if (tape.parse(json) != expected) {
+            expect(false, expected ? "valid rejected" : "malformed accepted", json, isa);
+            if (gFailures > 20) {
+                return;
+            }
+        }
+    }
+}
+
+//-------------------------------------
+int
+main() {
+    Molly::JsonTape tape;
+    for (int isa = int(Molly::StructuralIndex::detect()); isa >= 0; --isa) {
+        tape.getIndex().setIsa(Molly::StructuralIndex::Isa(isa));
+        checkFixed(tape, tape.getIndex().getIsa());
+        checkMutations(tape, tape.getIndex().getIsa());
+    }
+
+    if (gFailures != 0) {
+        std::printf("%d failures\n", gFailures);
+        return EXIT_FAILURE;
+    }
+    std::printf("jsonTapeTest: ok\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,367 @@
+//------------------------------------------------------------------------------
+// Generates the typed message structs and decoder schemas from
+// src/molly/messages.schema (see the format there).
+//
+// Usage: schemaGen <messages.schema> <output dir>
+// Writes messages.gen.h and messageSchemas.gen.h, only when they change.
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//-------------------------------------
+struct Field {
+    std::string     json;
+    std::string     type;       // C++ type
+    std::string     member;
+    bool            scalar {};  // Needs {} to start zeroed
+};
+
+//-------------------------------------
+struct MessageSpec {
+    std::string         tag;
+    std::string         name;
+    std::string         comment;
+    std::vector<Field>  fields;
+};
+
+//-------------------------------------
+struct TypeSpec {
+    std::string_view    schema;
+    std::string_view    cpp;
+    bool                scalar;
+};
+
+static constexpr TypeSpec kTypes[] = {
+    { "text",       "std::string_view", false },
+    { "int64",      "int64_t",          true  },
+    { "bool",       "bool",             true  },
+    { "double",     "double",           true  },
+    { "decimal",    "Decimal",          false },
+    { "timestamp",  "Timestamp",        false },
+    { "amount",     "Amount",           false },
+    { "bet_type",   "BetType",          false },
+    { "sport",      "SportCode",        false },
+    { "bookie",     "BookieCode",       false },
+};
+
+// Fields per message, as FieldMask has 32 bits
+static constexpr std::size_t kMaxFieldBits = 32;
+
+// event_id -> eventId, or EventId with upper
+//-------------------------------------
+static std::string
+camelCase(std::string_view name, bool upper = false) {
+    std::string result;
+    for (char c : name) {
+        if (c == '_') {
+            upper = true;
+            continue;
+        }
+        result += upper ? char(std::toupper(static_cast<unsigned char>(c))) : c;
+        upper = false;
+    }
+    return result;
+}
+
+//-------------------------------------
+static bool
+isIdentifier(std::string_view name) {
+    if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0]))) {
+        return false;
+    }
+    return std::all_of(name.begin(), name.end(), [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; });
+}
+
+//-------------------------------------
+static bool
+fail(const char *path, int line, const std::string &error) {
+    std::fprintf(stderr, "%s:%d: %s\n", path, line, error.c_str());
+    return false;
+}
+
+//-------------------------------------
+static bool
+parseSchema(const char *path, std::vector<MessageSpec> &messages) {
+    std::ifstream file(path);
+    if (file.is_open() == false) {
+        std::fprintf(stderr, "Cannot open '%s'\n", path);
+        return false;
+    }
+
+    std::string text;
+    for (int line = 1; std::getline(file, text); ++line) {
+        if (auto hash = text.find('#'); hash != std::string::npos) {
+            text.resize(hash);
+        }
+        std::string comment;
+        if (auto colon = text.find(':'); colon != std::string::npos) {
+            if (auto start = text.find_first_not_of(' ', colon + 1); start != std::string::npos) {
+                comment = text.substr(start);
+            }
+            text.resize(colon);
+        }
+
+        std::istringstream words(text);
+        std::vector<std::string> tokens;
+        for (std::string word; words >> word;) {
+            tokens.emplace_back(std::move(word));
+        }
+        if (tokens.empty()) {
+            continue;
+        }
+
+        if (tokens[0] == "message") {
+            if (messages.empty() == false && messages.back().fields.empty()) {
+                return fail(path, line, "message " + messages.back().tag + " has no fields");
+            }
+            if (tokens.size() != 3 || isIdentifier(tokens[2]) == false) {
+                return fail(path, line, "expected: message <tag> <Struct> [: <comment>]");
+            }
+            for (const auto &other : messages) {
+                if (other.tag == tokens[1] || other.name == tokens[2]) {
+                    return fail(path, line, "duplicate message " + tokens[1]);
+                }
+            }
+            messages.push_back({ tokens[1], tokens[2], comment, {} });
+            continue;
+        }
+
+        if (messages.empty()) {
+            return fail(path, line, "field outside a message");
+        }
+        if (tokens.size() < 2 || tokens.size() > 3) {
+            return fail(path, line, "expected: <json name> <type> [<member>]");
+        }
+        const auto *type = std::find_if(std::begin(kTypes), std::end(kTypes), [&](const TypeSpec &spec) { return spec.schema == tokens[1]; });
+        if (type == std::end(kTypes)) {
+            return fail(path, line, "unknown type " + tokens[1]);
+        }
+
+        Field field { tokens[0], std::string(type->cpp), tokens.size() == 3 ? tokens[2] : camelCase(tokens[0]), type->scalar };
+        if (isIdentifier(field.member) == false) {
+            return fail(path, line, "bad member name " + field.member);
+        }
+        auto &fields = messages.back().fields;
+        if (fields.size() == kMaxFieldBits) {
+            return fail(path, line, "more than " + std::to_string(kMaxFieldBits) + " fields");
+        }
+        for (const auto &other : fields) {
+            if (other.json == field.json || other.member == field.member) {
+                return fail(path, line, "duplicate field " + field.json);
+            }
+        }
+        fields.emplace_back(std::move(field));
+    }
+
+    if (messages.empty() || messages.back().fields.empty()) {
+        std::fprintf(stderr, "%s: no messages, or the last has no fields\n", path);
+        return false;
+    }
+    return true;
+}
+
+//-------------------------------------
+static std::string
+padded(std::string text, std::size_t width) {
+    if (text.size() < width) {
+        text.append(width - text.size(), ' ');
+    }
+    return text;
+}
+
+//-------------------------------------
+static std::string
+writeMessages(const std::vector<MessageSpec> &messages) {
+    std::size_t maxFields = 0;
+    for (const auto &message : messages) {
+        maxFields = std::max(maxFields, message.fields.size());
+    }
+
+    std::ostringstream out;
+    out << "// Generated by tools/schemaGen from src/molly/messages.schema, do not edit.\n"
+           "// Included by molly/messages.h.\n"
+           "#pragma once\n"
+           "\n"
+           "//-------------------------------------\n"
+           "namespace Molly {\n"
+           "\n"
+           "    // Largest schema, for the per field counters\n"
+           "    static constexpr std::size_t kMaxFields = " << maxFields << ";\n";
+
+    for (const auto &message : messages) {
+        out << "\n";
+        if (message.comment.empty() == false) {
+            out << "    // " << message.comment << "\n";
+        }
+        out << "    //---------------------------------\n"
+               "    struct " << message.name << " {\n";
+        for (const auto &field : message.fields) {
+            out << "        " << padded(field.type, 20) << field.member << (field.scalar ? " {}" : "") << ";\n";
+        }
+        out << "\n"
+               "        // FieldMask bits\n";
+        for (std::size_t i = 0; i < message.fields.size(); ++i) {
+            out << "        static constexpr FieldMask " << padded("k" + camelCase(message.fields[i].member, true), 24) << "= 1u << " << i << ";\n";
+        }
+        out << "    };\n";
+    }
+
+    // Per message merge, for MessageStore
+    for (const auto &message : messages) {
+        out << "\n"
+               "    // Fields in the mask, through copy(to.x, from.x); returns those that changed\n"
+               "    //---------------------------------\n"
+               "    template <typename Copy>\n"
+               "    inline FieldMask\n"
+               "    mergeFields(" << message.name << " &to, const " << message.name << " &from, FieldMask fields, Copy &&copy) {\n"
+               "        FieldMask changed = 0;\n";
+        for (const auto &field : message.fields) {
+            const auto bit = message.name + "::k" + camelCase(field.member, true);
+            out << "        if ((fields & " << bit << ") && copy(to." << field.member << ", from." << field.member << ")) {\n"
+                   "            changed |= " << bit << ";\n"
+                   "        }\n";
+        }
+        out << "        return changed;\n"
+               "    }\n";
+    }
+
+    out << "\n"
+           "    // Same order as Message alternatives\n"
+           "    //---------------------------------\n"
+           "    enum class MessageType : uint8_t {\n";
+    for (const auto &message : messages) {
+        out << "        " << message.name << ",\n";
+    }
+    out << "        Count,\n"
+           "    };\n"
+           "\n"
+           "    //---------------------------------\n"
+           "    using Message = std::variant<";
+    for (std::size_t i = 0; i < messages.size(); ++i) {
+        out << (i != 0 ? ", " : "") << messages[i].name;
+    }
+    out << ">;\n"
+           "\n"
+           "} // end of namespace\n";
+    return out.str();
+}
+
+// Per message: the field names, their perfect hash, and the decode
+// functions. find() switches on the hash slot (case labels are computed
+// by the compiler from kHash) and assign() on the field, reading straight
+// into the member, so neither goes through a table of function pointers.
+//-------------------------------------
+static std::string
+writeSchemas(const std::vector<MessageSpec> &messages) {
+    std::ostringstream out;
+    out << "// Generated by tools/schemaGen from src/molly/messages.schema, do not edit.\n"
+           "// Included by molly/messageDecoder.cpp, after MessageDecoder.\n"
+           "#pragma once\n"
+           "\n"
+           "//-------------------------------------\n"
+           "namespace Molly {\n";
+
+    for (const auto &message : messages) {
+        const auto count = std::to_string(message.fields.size());
+        out << "\n"
+               "    //---------------------------------\n"
+               "    template <>\n"
+               "    struct Schema<" << message.name << "> {\n"
+               "        static constexpr std::array<std::string_view, " << count << "> kNames = {\n";
+        for (const auto &field : message.fields) {
+            out << "            \"" << field.json << "\",\n";
+        }
+        out << "        };\n"
+               "\n"
+               "        static constexpr auto        kHash     = MindShake::makePerfectHash(kNames);\n"
+               "        static constexpr std::size_t kNotFound = " << count << ";\n"
+               "\n"
+               "        // Schema index of a key, kNotFound if it is not a field\n"
+               "        static std::size_t\n"
+               "        find(std::string_view name) {\n"
+               "            switch (kHash.slot(name)) {\n";
+        for (std::size_t i = 0; i < message.fields.size(); ++i) {
+            const auto &json = message.fields[i].json;
+            out << "                " << padded("case kHash.slot(\"" + json + "\"):", 40) << "return name == \"" << json << "\" ? " << i << " : kNotFound;\n";
+        }
+        out << "                default:                                return kNotFound;\n"
+               "            }\n"
+               "        }\n"
+               "\n"
+               "        // False if the value does not fit the member\n"
+               "        static bool\n"
+               "        assign(" << message.name << " &message, MessageDecoder &decoder, std::size_t field, std::size_t node) {\n"
+               "            switch (field) {\n";
+        for (std::size_t i = 0; i < message.fields.size(); ++i) {
+            out << "                " << padded("case " + std::to_string(i) + ":", 12) << "return decoder.read(node, message." << message.fields[i].member << ");\n";
+        }
+        out << "                default:    return false;\n"
+               "            }\n"
+               "        }\n"
+               "    };\n";
+    }
+
+    out << "\n"
+           "    // Stream tags, in MessageType order\n"
+           "    //---------------------------------\n"
+           "    static constexpr std::array<std::string_view, std::size_t(MessageType::Count)> kTypeNames = {\n";
+    for (const auto &message : messages) {
+        out << "        \"" << message.tag << "\",\n";
+    }
+    out << "    };\n"
+           "\n"
+           "} // end of namespace\n";
+    return out.str();
+}
+
+// Unchanged files keep their time stamp, so nothing gets rebuilt
+//-------------------------------------
+static bool
+writeIfChanged(const std::string &path, const std::string &content) {
+    {
+        std::ifstream current(path, std::ios::binary);
+        if (current.is_open()) {
+            std::ostringstream old;
+            old << current.rdbuf();
+            if (old.str() == content) {
+                return true;
+            }
+        }
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (file.is_open() == false || (file << content).good() == false) {
+        std::fprintf(stderr, "Cannot write '%s'\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+//-------------------------------------
+int
+main(int argc, char **argv) {
+    if (argc != 3) {
+        std::fprintf(stderr, "Usage: %s <messages.schema> <output dir>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<MessageSpec> messages;
+    if (parseSchema(argv[1], messages) == false) {
+        return EXIT_FAILURE;
+    }
+
+    const std::string dir = argv[2];
+    if (writeIfChanged(dir + "/messages.gen.h", writeMessages(messages)) == false ||
+        writeIfChanged(dir + "/messageSchemas.gen.h", writeSchemas(messages)) == false) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}